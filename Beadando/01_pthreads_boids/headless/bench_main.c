@@ -0,0 +1,88 @@
+/*
+   Headless benchmark driver (make bench): the simulation core and the updater backends
+   without SDL. Flags, world seed, tick length and report lines come from bench_core, the same
+   code boids_benchmark.exe --benchmark runs, so the numbers of the peaceful game compare.
+*/
+
+#include "bench_core.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef struct HeadlessRun {
+    Updater updater;
+    World world;
+} HeadlessRun;
+
+static void print_usage(const char* exe) {
+    printf("Usage: %s [--benchmark N] [--compare] [--mode seq|pthread|openmp] [--threads N] [--boids N] [--width W] [--height H]\n", exe);
+    bench_print_options_usage();
+    printf("         --compare runs every built-in backend (seq, pthread, openmp) on the same world and prints a speedup table\n");
+    printf("Same simulation, seed and tick (1/120 s) as boids_benchmark.exe --benchmark in the peaceful game, without SDL.\n");
+}
+
+/* the updater first, so its workers first-touch the world buffers, as in app_create_world_and_updater */
+static bool headless_create(void* ctx, const BenchOptions* o, BenchTarget* out) {
+    HeadlessRun* r = (HeadlessRun*)ctx;
+    WorldParallel par;
+
+    if (!bench_updater_init(&r->updater, o)) return false;
+    if (!world_init(&r->world, o->width, o->height, (size_t)o->boidCount, bench_world_seed(o->seed, 0),
+                    updater_parallel(&r->updater, &par))) {
+        fprintf(stderr, "world_init failed\n");
+        updater_destroy(&r->updater);
+        return false;
+    }
+    bench_world_configure(&r->world, o);
+    world_update_population(&r->world);
+
+    out->world = &r->world;
+    out->updater = &r->updater;
+    return true;
+}
+
+static void headless_destroy(void* ctx) {
+    HeadlessRun* r = (HeadlessRun*)ctx;
+
+    world_destroy(&r->world);
+    updater_destroy(&r->updater);
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opt;
+    HeadlessRun run;
+    const BenchDriver driver = {"peaceful", &run, headless_create, headless_destroy};
+    bool compare = false;
+
+    bench_options_init(&opt);
+    opt.benchmarkSteps = BENCH_DEFAULT_STEPS;
+    for (int i = 1; i < argc; i++) {
+        int used;
+
+        if (strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+        if (strcmp(argv[i], "--compare") == 0) {
+            compare = true;
+            continue;
+        }
+        used = bench_options_parse(&opt, argc, argv, &i);
+        if (used < 0) return 2;
+        if (used > 0) continue;
+
+        fprintf(stderr, "Unknown arg: %s\n", argv[i]);
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    if (!bench_options_finish(&opt)) {
+        return 2;
+    }
+    if (opt.benchmarkSteps <= 0) {
+        fprintf(stderr, "Benchmark mode needs a positive step count. Use --benchmark N\n");
+        return 2;
+    }
+    return compare ? bench_run_compare(&opt, &driver) : bench_run_single(&opt, &driver);
+}
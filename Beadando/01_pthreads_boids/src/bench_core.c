@@ -0,0 +1,904 @@
+#include "bench_core.h"
+
+#include "bench_stats.h"
+#include "perf_counters.h"
+#include "profiler.h"
+#include "trace.h"
+#include "update_pthreads.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+   --perf: one counter set per thread that runs updater parts, opened on that thread through the
+   updater's fork-join, and one for the calling thread (the serial phases). sets[p] stays closed
+   when part p runs on the calling thread itself; its counts are in the caller set then.
+*/
+typedef struct ThreadPerf {
+    size_t partCount;
+    PerfCounters* sets; /* partCount parts, then the calling thread */
+    PerfCounterValues* values; /* same order, filled by thread_perf_close */
+    bool* partOnCaller;
+    bool callerIsPart;
+    unsigned mask;
+} ThreadPerf;
+
+static FILE* g_benchLogFile = NULL;
+
+int bench_parse_int(const char* s, int defaultValue) {
+    if (s == NULL) return defaultValue;
+    char* end = NULL;
+    long v = strtol(s, &end, 10);
+    if (end == s) return defaultValue;
+    return (int)v;
+}
+
+float bench_parse_float(const char* s, float defaultValue) {
+    if (s == NULL) return defaultValue;
+    char* end = NULL;
+    double v = strtod(s, &end);
+    if (end == s) return defaultValue;
+    return (float)v;
+}
+
+uint64_t bench_parse_u64(const char* s, uint64_t defaultValue) {
+    if (s == NULL) return defaultValue;
+    char* end = NULL;
+    unsigned long long v = strtoull(s, &end, 0);
+    if (end == s) return defaultValue;
+    return (uint64_t)v;
+}
+
+bool bench_parse_kernel(const char* s, BoidKernel* outKernel) {
+    if (!s || !outKernel) return false;
+    if (strcmp(s, "auto") == 0) *outKernel = BOID_KERNEL_AUTO;
+    else if (strcmp(s, "scalar") == 0) *outKernel = BOID_KERNEL_SCALAR;
+    else if (strcmp(s, "sse2") == 0) *outKernel = BOID_KERNEL_SSE2;
+    else if (strcmp(s, "avx2") == 0) *outKernel = BOID_KERNEL_AVX2;
+    else return false;
+    return true;
+}
+
+static bool parse_mode(const char* s, UpdaterKind* outMode) {
+    for (int k = 0; k < UPDATER_KIND_COUNT; k++) {
+        if (strcmp(s, updater_kind_name((UpdaterKind)k)) == 0) {
+            *outMode = (UpdaterKind)k;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parse_schedule(const char* s, UpdateSchedule* outSchedule) {
+    if (strcmp(s, "static") == 0) *outSchedule = UPDATE_SCHEDULE_STATIC;
+    else if (strcmp(s, "chunked") == 0) *outSchedule = UPDATE_SCHEDULE_CHUNKED;
+    else if (strcmp(s, "cost") == 0) *outSchedule = UPDATE_SCHEDULE_COST;
+    else return false;
+    return true;
+}
+
+/* "compact", "scatter", "list:0,2,4" or just "0,2,4" */
+static bool parse_pin(const char* s, BenchOptions* o) {
+    if (strcmp(s, "none") == 0) o->pinMode = CPU_PIN_NONE;
+    else if (strcmp(s, "compact") == 0) o->pinMode = CPU_PIN_COMPACT;
+    else if (strcmp(s, "scatter") == 0) o->pinMode = CPU_PIN_SCATTER;
+    else {
+        const char* p = strncmp(s, "list:", 5) == 0 ? s + 5 : s;
+        o->pinListCount = 0;
+        while (*p) {
+            char* end = NULL;
+            long cpu = strtol(p, &end, 10);
+            if (end == p || cpu < 0 || o->pinListCount >= CPU_PIN_LIST_MAX) return false;
+            o->pinList[o->pinListCount++] = (int)cpu;
+            p = end;
+            if (*p == ',') p++;
+            else if (*p) return false;
+        }
+        if (o->pinListCount == 0) return false;
+        o->pinMode = CPU_PIN_LIST;
+    }
+    return true;
+}
+
+void bench_options_init(BenchOptions* o) {
+    memset(o, 0, sizeof(*o));
+    o->width = 80;
+    o->height = 25;
+    o->boidCount = 800;
+    o->threadCount = 4;
+    o->mode = UPDATER_PTHREAD;
+    o->benchmarkSteps = 0;
+    o->benchmarkWarmup = BENCH_WARMUP_STEPS;
+    o->kernel = BOID_KERNEL_AUTO;
+    o->mortonInterval = 0;
+    o->verletLists = false;
+    o->verletSkin = 1.5f;
+    o->allPairs = false;
+    o->seed = BENCH_DEFAULT_SEED;
+    o->seedSet = false;
+    o->spinLimit = -1;
+    o->schedule = UPDATE_SCHEDULE_CHUNKED;
+    o->chunkSize = UPDATE_DEFAULT_CHUNK;
+    o->callerWorks = true;
+    o->pinMode = CPU_PIN_NONE;
+    o->pinListCount = 0;
+    o->batchTicks = false;
+    o->benchTrials = 1;
+    o->benchRejectOutliers = false;
+    o->benchOutPath = NULL;
+    o->profile = false;
+    o->perfCounters = false;
+}
+
+int bench_options_parse(BenchOptions* o, int argc, char** argv, int* i) {
+    const char* arg = argv[*i];
+    const char* val = *i + 1 < argc ? argv[*i + 1] : NULL;
+
+    if (strcmp(arg, "--batch") == 0) o->batchTicks = true;
+    else if (strcmp(arg, "--reject-outliers") == 0) o->benchRejectOutliers = true;
+    else if (strcmp(arg, "--profile") == 0) o->profile = true;
+    else if (strcmp(arg, "--perf") == 0) o->perfCounters = true;
+    else {
+        if (!val) return 0;
+        if (strcmp(arg, "--mode") == 0) {
+            if (!parse_mode(val, &o->mode)) {
+                fprintf(stderr, "Unknown mode: %s\n", val);
+                return -1;
+            }
+        } else if (strcmp(arg, "--kernel") == 0) {
+            if (!bench_parse_kernel(val, &o->kernel)) {
+                fprintf(stderr, "Unknown kernel: %s\n", val);
+                return -1;
+            }
+        } else if (strcmp(arg, "--neighbors") == 0) {
+            o->verletLists = strcmp(val, "verlet") == 0;
+            o->allPairs = strcmp(val, "allpairs") == 0;
+            if (!o->verletLists && !o->allPairs && strcmp(val, "grid") != 0) {
+                fprintf(stderr, "Unknown neighbor mode: %s\n", val);
+                return -1;
+            }
+        } else if (strcmp(arg, "--schedule") == 0) {
+            if (!parse_schedule(val, &o->schedule)) {
+                fprintf(stderr, "Unknown schedule: %s\n", val);
+                return -1;
+            }
+        } else if (strcmp(arg, "--caller") == 0) {
+            if (strcmp(val, "work") == 0) o->callerWorks = true;
+            else if (strcmp(val, "wait") == 0) o->callerWorks = false;
+            else {
+                fprintf(stderr, "Unknown caller mode: %s\n", val);
+                return -1;
+            }
+        } else if (strcmp(arg, "--pin") == 0) {
+            if (!parse_pin(val, o)) {
+                fprintf(stderr, "Unknown pin mode: %s\n", val);
+                return -1;
+            }
+        } else if (strcmp(arg, "--seed") == 0) {
+            o->seed = bench_parse_u64(val, o->seed);
+            o->seedSet = true;
+        } else if (strcmp(arg, "--benchmark") == 0) o->benchmarkSteps = bench_parse_int(val, o->benchmarkSteps);
+        else if (strcmp(arg, "--threads") == 0) o->threadCount = bench_parse_int(val, o->threadCount);
+        else if (strcmp(arg, "--boids") == 0) o->boidCount = bench_parse_int(val, o->boidCount);
+        else if (strcmp(arg, "--width") == 0) o->width = bench_parse_int(val, o->width);
+        else if (strcmp(arg, "--height") == 0) o->height = bench_parse_int(val, o->height);
+        else if (strcmp(arg, "--morton") == 0) o->mortonInterval = bench_parse_int(val, o->mortonInterval);
+        else if (strcmp(arg, "--skin") == 0) o->verletSkin = bench_parse_float(val, o->verletSkin);
+        else if (strcmp(arg, "--chunk") == 0) o->chunkSize = bench_parse_int(val, o->chunkSize);
+        else if (strcmp(arg, "--spin") == 0) o->spinLimit = bench_parse_int(val, o->spinLimit);
+        else if (strcmp(arg, "--trials") == 0) o->benchTrials = bench_parse_int(val, o->benchTrials);
+        else if (strcmp(arg, "--bench-out") == 0) o->benchOutPath = val;
+        else return 0;
+        (*i)++;
+    }
+    return 1;
+}
+
+bool bench_options_finish(BenchOptions* o) {
+    if (o->width <= 10 || o->height <= 10 || o->boidCount <= 0 || o->threadCount <= 0 || o->mortonInterval < 0 ||
+        o->verletSkin < 0.0f || o->spinLimit < -1 || o->chunkSize <= 0 || o->benchTrials <= 0) {
+        fprintf(stderr, "Invalid config. Use --help\n");
+        return false;
+    }
+    if (!updater_ops(o->mode)) {
+        fprintf(stderr, "Mode %s is not built into this binary (compile with -fopenmp)\n", updater_kind_name(o->mode));
+        return false;
+    }
+    if (!boids_kernel_supported(o->kernel)) {
+        fprintf(stderr, "Kernel %s is not supported by this CPU\n", boids_kernel_name(o->kernel));
+        return false;
+    }
+    if (o->kernel == BOID_KERNEL_AUTO) {
+        o->kernel = boids_best_kernel();
+    }
+    return true;
+}
+
+void bench_print_options_usage(void) {
+    printf("Options: --kernel auto|scalar|sse2|avx2 selects the neighbor loop (default: auto, best supported)\n");
+    printf("         --neighbors grid|verlet|allpairs picks the neighbor search, --skin S the Verlet skin radius (default: grid, 1.5);\n");
+    printf("           allpairs is the single-cell scan of every boid, the reference of --grid-check\n");
+    printf("         --morton K re-sorts the boids in Morton (Z-curve) order every K ticks (default: off)\n");
+    printf("         --schedule static|chunked|cost splits the pthread/openmp step into fixed slices, --chunk N boid chunks or\n");
+    printf("           slices balanced by the previous tick's neighbor counts (default: chunked, %d)\n", UPDATE_DEFAULT_CHUNK);
+    printf("         --caller work|wait: with work (default) --threads N counts the main thread as one of the N workers\n");
+    printf("         --pin compact|scatter|list:C0,C1,.. binds pthread part p to a cpu (default: none, the OS decides)\n");
+    printf("           the workers first-touch their slice of the world; that only matches the slices they step with\n");
+    printf("           --schedule static|cost, chunked hands out chunks regardless of who touched them\n");
+    printf("         --batch runs the measured benchmark ticks back-to-back inside the pthread workers\n");
+    printf("         --spin S sets how long the pthread workers spin at the tick barrier before sleeping (0 = sleep at once)\n");
+    printf("         --trials K repeats a single benchmark K times and adds a 95%% confidence interval of the average\n");
+    printf("         --reject-outliers leaves tick times outside the Tukey fences (1.5 IQR) out of the statistics\n");
+    printf("         --bench-out FILE writes the tick statistics per trial as CSV (JSON if FILE ends in .json)\n");
+    printf("         --profile times the tick phases (bounds, input, shockwave, reorder, grid, step, swap, rules);\n");
+    printf("           printed by single benchmarks\n");
+    printf("         --perf adds hardware counters of the measured ticks (Linux): IPC, L1D/LLC/branch misses and\n");
+    printf("           stalled cycles per tick and per neighbor candidate pair, in total and per updater thread\n");
+    printf("         --seed N fixes the world seed (default: %u for benchmarks)\n", BENCH_DEFAULT_SEED);
+}
+
+uint64_t bench_world_seed(uint64_t seed, uint64_t resetIndex) {
+    return boids_rng_u64(seed, BENCH_RNG_STREAM_RESET, resetIndex);
+}
+
+UpdaterOptions bench_updater_options(const BenchOptions* o) {
+    const UpdaterOptions opt = {
+        .threadCount = (size_t)o->threadCount,
+        .callerWorks = o->callerWorks,
+        .spinLimit = o->spinLimit,
+        .schedule = o->schedule,
+        .chunkSize = (size_t)o->chunkSize,
+    };
+    return opt;
+}
+
+bool bench_updater_init(Updater* u, const BenchOptions* o) {
+    const UpdaterOptions opt = bench_updater_options(o);
+
+    if (!updater_init(u, o->mode, &opt)) {
+        fprintf(stderr, "%s updater init failed\n", updater_kind_name(o->mode));
+        return false;
+    }
+    if (o->pinMode != CPU_PIN_NONE && u->ops->pin) {
+        int* cpus = (int*)calloc((size_t)o->threadCount, sizeof(int));
+        if (!cpus || !cpu_pin_plan(o->pinMode, o->pinList, o->pinListCount, (size_t)o->threadCount, cpus) ||
+            !u->ops->pin(u, cpus)) {
+            fprintf(stderr, "Warning: CPU pinning (%s) failed, threads stay unpinned.\n", cpu_pin_mode_name(o->pinMode));
+        }
+        free(cpus);
+    }
+    return true;
+}
+
+void bench_world_configure(World* w, const BenchOptions* o) {
+    (void)world_set_kernel(w, o->kernel);
+    w->sortInterval = o->mortonInterval;
+    w->useGrid = !o->allPairs;
+    if (!world_set_neighbor_lists(w, o->verletLists, o->verletSkin)) {
+        fprintf(stderr, "Warning: Verlet neighbor lists unavailable, using the grid scan.\n");
+    }
+}
+
+void bench_set_log_file(FILE* f) {
+    g_benchLogFile = f;
+}
+
+void bench_write_text(const char* text) {
+    if (!text) return;
+
+    fputs(text, stdout);
+    fflush(stdout);
+
+    if (g_benchLogFile) {
+        fputs(text, g_benchLogFile);
+        fflush(g_benchLogFile);
+    }
+}
+
+void bench_printf(const char* fmt, ...) {
+    char text[768];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(text, sizeof(text), fmt, ap);
+    va_end(ap);
+
+    bench_write_text(text);
+}
+
+static void bench_step(BenchTarget* t, double dt) {
+    TRACE_BEGIN(t0);
+    updater_step(t->updater, t->world, dt);
+    TRACE_END(t0, "tick");
+}
+
+/* with --batch the backend runs all ticks in one go (the pthread workers without returning to the main thread) */
+static void bench_step_n(BenchTarget* t, const BenchOptions* o, int steps) {
+    if (o->batchTicks) {
+        if (steps > 0) updater_run(t->updater, t->world, BENCH_SIM_DT, (size_t)steps);
+        return;
+    }
+    for (int i = 0; i < steps; i++) {
+        bench_step(t, BENCH_SIM_DT);
+    }
+}
+
+/* set on the calling thread while thread_perf_open runs the parts */
+static _Thread_local bool t_perfCallerThread = false;
+
+static void thread_perf_open_part(void* arg, size_t part, size_t partCount) {
+    ThreadPerf* tp = (ThreadPerf*)arg;
+
+    (void)partCount;
+    if (t_perfCallerThread) {
+        tp->partOnCaller[part] = true;
+        tp->callerIsPart = true;
+        return;
+    }
+    (void)perf_counters_open_thread(&tp->sets[part], tp->mask);
+}
+
+static void thread_perf_free(ThreadPerf* tp) {
+    free(tp->sets);
+    free(tp->values);
+    free(tp->partOnCaller);
+    memset(tp, 0, sizeof(*tp));
+}
+
+/* false only without memory; counters that do not open are reported by print_thread_perf */
+static bool thread_perf_open(ThreadPerf* tp, Updater* u, unsigned mask) {
+    WorldParallel storage;
+    const WorldParallel* par = updater_parallel(u, &storage);
+
+    memset(tp, 0, sizeof(*tp));
+    tp->partCount = par ? par->partCount : 1;
+    tp->mask = mask;
+    tp->sets = (PerfCounters*)calloc(tp->partCount + 1, sizeof(PerfCounters));
+    tp->values = (PerfCounterValues*)calloc(tp->partCount + 1, sizeof(PerfCounterValues));
+    tp->partOnCaller = (bool*)calloc(tp->partCount, sizeof(bool));
+    if (!tp->sets || !tp->values || !tp->partOnCaller) {
+        thread_perf_free(tp);
+        return false;
+    }
+    for (size_t i = 0; i <= tp->partCount; i++) {
+        for (int k = 0; k < PERF_COUNTER_COUNT; k++) tp->sets[i].fd[k] = -1;
+    }
+
+    t_perfCallerThread = true;
+    (void)perf_counters_open_thread(&tp->sets[tp->partCount], mask);
+    if (par) par->run(par->ctx, thread_perf_open_part, tp);
+    else thread_perf_open_part(tp, 0, 1);
+    t_perfCallerThread = false;
+    return true;
+}
+
+static void thread_perf_start(ThreadPerf* tp) {
+    for (size_t i = 0; i <= tp->partCount; i++) perf_counters_start(&tp->sets[i]);
+}
+
+static void thread_perf_stop(ThreadPerf* tp) {
+    for (size_t i = 0; i <= tp->partCount; i++) perf_counters_stop(&tp->sets[i]);
+}
+
+static void thread_perf_close(ThreadPerf* tp) {
+    for (size_t i = 0; i <= tp->partCount; i++) perf_counters_close(&tp->sets[i], &tp->values[i]);
+}
+
+/* sum of all threads; a counter is valid when it counted on at least one of them */
+static void thread_perf_total(const ThreadPerf* tp, PerfCounterValues* total) {
+    memset(total, 0, sizeof(*total));
+    for (size_t i = 0; i <= tp->partCount; i++) {
+        for (int k = 0; k < PERF_COUNTER_COUNT; k++) {
+            if (!tp->values[i].valid[k]) continue;
+            total->valid[k] = true;
+            total->value[k] += tp->values[i].value[k];
+        }
+    }
+}
+
+static BenchmarkResult bench_measure(BenchTarget* t, const BenchOptions* o, int warmupSteps, int measureSteps, double* tickMs,
+                                     ThreadPerf* perf) {
+    BenchmarkResult result = {0};
+
+    bench_step_n(t, o, warmupSteps);
+    if (t->updater->ops->reset_stats) t->updater->ops->reset_stats(t->updater);
+
+    {
+        const size_t rebuilds0 = t->world->lists.rebuilds;
+        const uint64_t pairs0 = t->world->stepPairs;
+        if (perf) thread_perf_start(perf);
+        uint64_t t0 = profiler_now_ns();
+        if (tickMs && !o->batchTicks) {
+            uint64_t c0 = t0;
+            for (int i = 0; i < measureSteps; i++) {
+                uint64_t c1;
+                bench_step(t, BENCH_SIM_DT);
+                c1 = profiler_now_ns();
+                tickMs[i] = (double)(c1 - c0) / 1000000.0;
+                c0 = c1;
+            }
+            result.tickSamples = (size_t)measureSteps;
+        } else {
+            bench_step_n(t, o, measureSteps);
+        }
+        uint64_t t1 = profiler_now_ns();
+        if (perf) thread_perf_stop(perf);
+        result.totalMs = (double)(t1 - t0) / 1000000.0;
+        result.neighborRebuilds = (unsigned long)(t->world->lists.rebuilds - rebuilds0);
+        result.candidatePairs = t->world->stepPairs - pairs0;
+    }
+
+    if (measureSteps > 0) {
+        result.avgMs = result.totalMs / (double)measureSteps;
+    }
+    if (result.totalMs > 0.0) {
+        result.ticksPerSecond = (double)measureSteps * 1000.0 / result.totalMs;
+    }
+
+    return result;
+}
+
+BenchmarkResult bench_run_samples(BenchTarget* t, const BenchOptions* o, int warmupSteps, int measureSteps, double* tickMs) {
+    return bench_measure(t, o, warmupSteps, measureSteps, tickMs, NULL);
+}
+
+BenchmarkResult bench_run(BenchTarget* t, const BenchOptions* o) {
+    return bench_measure(t, o, o->benchmarkWarmup, o->benchmarkSteps, NULL, NULL);
+}
+
+BenchmarkResult bench_run_counted(BenchTarget* t, const BenchOptions* o, unsigned mask, PerfCounterValues* total) {
+    ThreadPerf perf;
+    BenchmarkResult result;
+
+    memset(total, 0, sizeof(*total));
+    if (!thread_perf_open(&perf, t->updater, mask)) return bench_run(t, o);
+    result = bench_measure(t, o, o->benchmarkWarmup, o->benchmarkSteps, NULL, &perf);
+    thread_perf_close(&perf);
+    thread_perf_total(&perf, total);
+    thread_perf_free(&perf);
+    return result;
+}
+
+static const char* neighbor_mode_text(const BenchOptions* o, char* buf, size_t size) {
+    if (o->allPairs) return "allpairs";
+    if (!o->verletLists) return "grid";
+    snprintf(buf, size, "verlet(skin=%.2f)", (double)o->verletSkin);
+    return buf;
+}
+
+static const char* rebuild_text(const BenchOptions* o, const BenchmarkResult* result, char* buf, size_t size) {
+    if (!o->verletLists) return "";
+    snprintf(buf, size, " rebuilds=%lu (every %.1f ticks)",
+             result->neighborRebuilds,
+             result->neighborRebuilds > 0 ? (double)o->benchmarkSteps / (double)result->neighborRebuilds : 0.0);
+    return buf;
+}
+
+static const char* schedule_text(const BenchOptions* o, char* buf, size_t size) {
+    if (o->mode == UPDATER_SEQ) return "";
+    if (o->schedule == UPDATE_SCHEDULE_CHUNKED) {
+        snprintf(buf, size, " schedule=chunked(%d) pin=%s%s", o->chunkSize, cpu_pin_mode_name(o->pinMode),
+                 o->batchTicks ? " batch" : "");
+    } else {
+        snprintf(buf, size, " schedule=%s pin=%s%s", update_schedule_name(o->schedule), cpu_pin_mode_name(o->pinMode),
+                 o->batchTicks ? " batch" : "");
+    }
+    return buf;
+}
+
+/* the loop that actually walks the neighbors: the Verlet list walk has only a scalar version */
+static BoidKernel neighbor_kernel(const BenchOptions* o) {
+    return o->verletLists ? BOID_KERNEL_SCALAR : o->kernel;
+}
+
+void bench_print_result(const BenchOptions* o, const char* game, const BenchmarkResult* result) {
+    char text[512];
+    char neighbors[48];
+    char rebuilds[64];
+    char schedule[48];
+
+    snprintf(text, sizeof(text),
+             "benchmark mode=%s%s game=%s kernel=%s neighbors=%s section=world_update_only threads=%d boids=%d size=%dx%d steps=%d total=%.3f ms avg=%.3f ms/tick ticks=%.2f/s%s\n",
+             updater_kind_name(o->mode),
+             schedule_text(o, schedule, sizeof(schedule)),
+             game,
+             boids_kernel_name(neighbor_kernel(o)),
+             neighbor_mode_text(o, neighbors, sizeof(neighbors)),
+             o->threadCount,
+             o->boidCount,
+             o->width,
+             o->height,
+             o->benchmarkSteps,
+             result->totalMs,
+             result->avgMs,
+             result->ticksPerSecond,
+             rebuild_text(o, result, rebuilds, sizeof(rebuilds)));
+
+    bench_write_text(text);
+}
+
+void bench_print_thread_stats(const Updater* u) {
+    if (!u->ops->thread_stats) return;
+
+    for (size_t i = 0; i < u->threadCount; i++) {
+        UpdateThreadStats st;
+        if (!u->ops->thread_stats(u, i, &st)) break;
+        const double total = st.busyMs + st.idleMs;
+        bench_printf("  thread %u busy=%.3f ms idle=%.3f ms (%.1f%% busy)\n",
+                     (unsigned)i,
+                     st.busyMs,
+                     st.idleMs,
+                     total > 0.0 ? 100.0 * st.busyMs / total : 0.0);
+    }
+}
+
+static void print_perf_unavailable(const PerfCounters* pc) {
+    const int paranoid = perf_event_paranoid_level();
+
+    if (pc->firstError == EACCES || pc->firstError == EPERM) {
+        bench_printf("  perf: not permitted (perf_event_paranoid=%d, needs <= 2 or CAP_PERFMON)\n", paranoid);
+    } else if (pc->firstError != 0) {
+        bench_printf("  perf: no hardware counters (%s)\n", strerror(pc->firstError));
+    } else {
+        bench_printf("  perf: unavailable on this platform\n");
+    }
+}
+
+/* one line of counters per tick of the measured ticks; with pairs > 0 also per candidate pair */
+static void print_perf_line(const BenchOptions* o, const char* label, const PerfCounterValues* v, uint64_t pairs) {
+    const double ticks = (double)o->benchmarkSteps;
+    char text[768];
+    size_t len;
+
+    len = (size_t)snprintf(text, sizeof(text), "  %s:", label);
+    if (v->valid[PERF_COUNTER_CYCLES] && v->valid[PERF_COUNTER_INSTRUCTIONS] && v->value[PERF_COUNTER_CYCLES] > 0.0) {
+        len += (size_t)snprintf(text + len, sizeof(text) - len, " ipc=%.2f",
+                                v->value[PERF_COUNTER_INSTRUCTIONS] / v->value[PERF_COUNTER_CYCLES]);
+    } else {
+        len += (size_t)snprintf(text + len, sizeof(text) - len, " ipc=n/a");
+    }
+    for (int k = 0; k < PERF_COUNTER_COUNT && len < sizeof(text); k++) {
+        if (!v->valid[k]) {
+            len += (size_t)snprintf(text + len, sizeof(text) - len, " %s/tick=n/a", perf_counter_name((PerfCounterKind)k));
+            continue;
+        }
+        len += (size_t)snprintf(text + len, sizeof(text) - len, " %s/tick=%.0f", perf_counter_name((PerfCounterKind)k),
+                                v->value[k] / ticks);
+    }
+    if (pairs > 0 && len < sizeof(text)) {
+        const PerfCounterKind perPair[] = {PERF_COUNTER_L1D_MISSES, PERF_COUNTER_LLC_MISSES, PERF_COUNTER_BRANCH_MISSES};
+        len += (size_t)snprintf(text + len, sizeof(text) - len, " pairs/tick=%.0f", (double)pairs / ticks);
+        for (size_t i = 0; i < sizeof(perPair) / sizeof(perPair[0]) && len < sizeof(text); i++) {
+            if (!v->valid[perPair[i]]) continue;
+            len += (size_t)snprintf(text + len, sizeof(text) - len, " %s/pair=%.4f", perf_counter_name(perPair[i]),
+                                    v->value[perPair[i]] / (double)pairs);
+        }
+    }
+    if (len < sizeof(text) - 1) {
+        text[len++] = '\n';
+        text[len] = '\0';
+    } else {
+        text[sizeof(text) - 2] = '\n';
+    }
+    bench_write_text(text);
+}
+
+/*
+   --perf: the sum of all threads per tick and per candidate pair looked at in the measured
+   ticks, then one row per part thread next to bench_print_thread_stats, so a straggler or a
+   worker that thrashes its cache shows up.
+*/
+static void print_thread_perf(const BenchOptions* o, const ThreadPerf* tp, uint64_t pairs) {
+    const PerfCounters* caller = &tp->sets[tp->partCount];
+    const PerfCounterValues* values = tp->values;
+    PerfCounterValues total;
+    char label[48];
+
+    if (caller->openCount == 0) {
+        print_perf_unavailable(caller);
+        return;
+    }
+
+    thread_perf_total(tp, &total);
+    print_perf_line(o, "perf", &total, pairs);
+
+    for (size_t p = 0; p < tp->partCount; p++) {
+        if (tp->partOnCaller[p]) {
+            snprintf(label, sizeof(label), "thread %u perf (caller, serial phases too)", (unsigned)p);
+            print_perf_line(o, label, &values[tp->partCount], 0);
+        } else {
+            snprintf(label, sizeof(label), "thread %u perf", (unsigned)p);
+            print_perf_line(o, label, &values[p], 0);
+        }
+    }
+    if (!tp->callerIsPart) print_perf_line(o, "caller perf (serial phases)", &values[tp->partCount], 0);
+}
+
+/* whole-run phase times (warmup included) of a profiled benchmark; only the updater phases run headless */
+static void print_phase_stats(PhaseProfiler* p) {
+    PhaseTotals totals;
+    char text[512];
+    double tickMs;
+
+    profiler_read(p, &totals, false);
+    tickMs = profiler_format(&totals, NULL, PROF_SIM_FIRST, PROF_SIM_LAST, text, sizeof(text));
+    bench_printf("  phases avg/max ms (%.3f per tick): %s\n", tickMs, text);
+}
+
+static void print_tick_stats(const char* label, const BenchStats* st) {
+    bench_printf("  %s ms: n=%lu min=%.3f p50=%.3f p90=%.3f p99=%.3f max=%.3f mean=%.3f stddev=%.3f rejected=%lu\n",
+                 label,
+                 (unsigned long)st->count,
+                 st->min,
+                 st->p50,
+                 st->p90,
+                 st->p99,
+                 st->max,
+                 st->mean,
+                 st->stddev,
+                 (unsigned long)st->rejected);
+}
+
+static bool path_has_suffix(const char* path, const char* suffix) {
+    const size_t n = strlen(path);
+    const size_t k = strlen(suffix);
+    return n >= k && strcmp(path + n - k, suffix) == 0;
+}
+
+/* one CSV row / JSON object of tick statistics; hasStats = false leaves the fields empty (null) */
+static void bench_out_stats(FILE* f, bool json, bool hasStats, const BenchStats* st) {
+    if (!hasStats) {
+        fputs(json ? "\"ticks\":null,\"rejected\":null,\"min_ms\":null,\"p50_ms\":null,\"p90_ms\":null,\"p99_ms\":null,"
+                     "\"max_ms\":null,\"mean_ms\":null,\"stddev_ms\":null"
+                   : ",,,,,,,,",
+              f);
+        return;
+    }
+    fprintf(f,
+            json ? "\"ticks\":%lu,\"rejected\":%lu,\"min_ms\":%.6f,\"p50_ms\":%.6f,\"p90_ms\":%.6f,\"p99_ms\":%.6f,"
+                   "\"max_ms\":%.6f,\"mean_ms\":%.6f,\"stddev_ms\":%.6f"
+                 : "%lu,%lu,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f",
+            (unsigned long)st->count,
+            (unsigned long)st->rejected,
+            st->min,
+            st->p50,
+            st->p90,
+            st->p99,
+            st->max,
+            st->mean,
+            st->stddev);
+}
+
+/*
+   --bench-out: one record per trial and a summary over all of them (pooled tick statistics,
+   mean of the trial averages with its 95% confidence interval).
+*/
+static bool write_bench_out(const BenchOptions* o,
+                            const char* game,
+                            const BenchmarkResult* results,
+                            const BenchStats* stats,
+                            int trials,
+                            bool hasPooled,
+                            const BenchStats* pooled,
+                            double trialMean,
+                            double ci95) {
+    const bool json = path_has_suffix(o->benchOutPath, ".json");
+    const char* schedule = o->mode == UPDATER_SEQ ? "" : update_schedule_name(o->schedule);
+    FILE* f = fopen(o->benchOutPath, "w");
+
+    if (!f) return false;
+
+    if (json) {
+        fprintf(f,
+                "{\"mode\":\"%s\",\"schedule\":\"%s\",\"batch\":%s,\"game\":\"%s\",\"kernel\":\"%s\",\"threads\":%d,"
+                "\"boids\":%d,\"width\":%d,\"height\":%d,\"steps\":%d,\"seed\":%llu,\"reject_outliers\":%s,\n\"trials\":[\n",
+                updater_kind_name(o->mode),
+                schedule,
+                o->batchTicks ? "true" : "false",
+                game,
+                boids_kernel_name(neighbor_kernel(o)),
+                o->threadCount,
+                o->boidCount,
+                o->width,
+                o->height,
+                o->benchmarkSteps,
+                (unsigned long long)o->seed,
+                o->benchRejectOutliers ? "true" : "false");
+        for (int t = 0; t < trials; t++) {
+            fprintf(f, "  {\"trial\":%d,\"total_ms\":%.6f,\"avg_ms\":%.6f,\"ticks_per_s\":%.3f,", t, results[t].totalMs,
+                    results[t].avgMs, results[t].ticksPerSecond);
+            bench_out_stats(f, true, results[t].tickSamples > 0, &stats[t]);
+            fputs(t + 1 < trials ? "},\n" : "}\n", f);
+        }
+        fprintf(f, "],\n\"summary\":{\"trials\":%d,\"avg_ms\":%.6f,\"ci95_ms\":%.6f,", trials, trialMean, ci95);
+        bench_out_stats(f, true, hasPooled, pooled);
+        fputs("}}\n", f);
+    } else {
+        fputs("mode,schedule,batch,game,kernel,threads,boids,width,height,steps,seed,trial,total_ms,avg_ms,ticks_per_s,ci95_ms,"
+              "ticks,rejected,min_ms,p50_ms,p90_ms,p99_ms,max_ms,mean_ms,stddev_ms\n",
+              f);
+        for (int t = 0; t <= trials; t++) {
+            const bool summary = t == trials;
+            fprintf(f, "%s,%s,%d,%s,%s,%d,%d,%d,%d,%d,%llu,",
+                    updater_kind_name(o->mode),
+                    schedule,
+                    o->batchTicks ? 1 : 0,
+                    game,
+                    boids_kernel_name(neighbor_kernel(o)),
+                    o->threadCount,
+                    o->boidCount,
+                    o->width,
+                    o->height,
+                    o->benchmarkSteps,
+                    (unsigned long long)o->seed);
+            if (summary) {
+                fprintf(f, "all,,%.6f,,%.6f,", trialMean, ci95);
+                bench_out_stats(f, false, hasPooled, pooled);
+            } else {
+                fprintf(f, "%d,%.6f,%.6f,%.3f,,", t, results[t].totalMs, results[t].avgMs, results[t].ticksPerSecond);
+                bench_out_stats(f, false, results[t].tickSamples > 0, &stats[t]);
+            }
+            fputc('\n', f);
+        }
+    }
+
+    return fclose(f) == 0;
+}
+
+/* one trial: a fresh world from the driver, the measured ticks and the per-run report lines */
+static bool run_trial(const BenchOptions* o, const BenchDriver* d, double* tickMs, BenchmarkResult* out) {
+    BenchTarget t;
+    ThreadPerf perf;
+    PhaseProfiler* profiler = NULL;
+
+    if (!d->create(d->ctx, o, &t)) return false;
+    /* on the updater's threads, so every row is one thread */
+    if (o->perfCounters && !thread_perf_open(&perf, t.updater, PERF_COUNTER_MASK_ALL)) {
+        fprintf(stderr, "out of memory for the perf counters\n");
+        d->destroy(d->ctx);
+        return false;
+    }
+    if (o->profile) {
+        profiler = (PhaseProfiler*)malloc(sizeof(PhaseProfiler));
+        if (profiler) {
+            profiler_init(profiler);
+            t.world->profiler = profiler;
+        } else {
+            fprintf(stderr, "Warning: no memory for the phase profiler.\n");
+        }
+    }
+
+    *out = bench_measure(&t, o, o->benchmarkWarmup, o->benchmarkSteps, tickMs, o->perfCounters ? &perf : NULL);
+    bench_print_result(o, d->game, out);
+    bench_print_thread_stats(t.updater);
+    if (o->perfCounters) {
+        thread_perf_close(&perf);
+        print_thread_perf(o, &perf, out->candidatePairs);
+        thread_perf_free(&perf);
+    }
+    if (profiler) print_phase_stats(profiler);
+
+    d->destroy(d->ctx);
+    free(profiler);
+    return true;
+}
+
+/*
+   --trials K repeats the run on a fresh world with the same seed, so the trials differ only by
+   timing noise. Every trial keeps its per-tick times for the percentile line.
+*/
+int bench_run_single(const BenchOptions* o, const BenchDriver* d) {
+    const int trials = o->benchTrials > 0 ? o->benchTrials : 1;
+    const size_t steps = (size_t)o->benchmarkSteps;
+    double* samples = (double*)malloc((size_t)trials * steps * sizeof(double));
+    double* trialAvg = (double*)malloc((size_t)trials * sizeof(double));
+    BenchmarkResult* results = (BenchmarkResult*)calloc((size_t)trials, sizeof(BenchmarkResult));
+    BenchStats* stats = (BenchStats*)calloc((size_t)trials, sizeof(BenchStats));
+    BenchStats pooled = {0};
+    bool hasPooled = true;
+    double trialMean = 0.0;
+    double ci95 = 0.0;
+    int rc = 0;
+
+    if (!samples || !trialAvg || !results || !stats) {
+        fprintf(stderr, "out of memory for %d x %d tick samples\n", trials, o->benchmarkSteps);
+        rc = 1;
+    }
+
+    for (int t = 0; rc == 0 && t < trials; t++) {
+        if (!run_trial(o, d, samples + (size_t)t * steps, &results[t])) {
+            rc = 1;
+            break;
+        }
+
+        trialAvg[t] = results[t].avgMs;
+        if (results[t].tickSamples > 0 &&
+            bench_stats_compute(samples + (size_t)t * steps, results[t].tickSamples, o->benchRejectOutliers, &stats[t])) {
+            print_tick_stats("tick", &stats[t]);
+            if (o->benchRejectOutliers) trialAvg[t] = stats[t].mean;
+        } else {
+            results[t].tickSamples = 0;
+            hasPooled = false;
+        }
+    }
+
+    if (rc != 0) {
+        free(samples);
+        free(trialAvg);
+        free(results);
+        free(stats);
+        return rc;
+    }
+
+    bench_stats_mean_ci95(trialAvg, (size_t)trials, &trialMean, &ci95);
+    if (hasPooled) hasPooled = bench_stats_compute(samples, (size_t)trials * steps, o->benchRejectOutliers, &pooled);
+    if (trials > 1) {
+        bench_printf("benchmark trials=%d avg=%.3f ms/tick ci95=+-%.3f ms (+-%.1f%%)\n",
+                     trials,
+                     trialMean,
+                     ci95,
+                     trialMean > 0.0 ? 100.0 * ci95 / trialMean : 0.0);
+        if (hasPooled) print_tick_stats("all ticks", &pooled);
+    }
+
+    if (o->benchOutPath && !write_bench_out(o, d->game, results, stats, trials, hasPooled, &pooled, trialMean, ci95)) {
+        fprintf(stderr, "Could not write %s\n", o->benchOutPath);
+        rc = 1;
+    }
+
+    free(samples);
+    free(trialAvg);
+    free(results);
+    free(stats);
+    return rc;
+}
+
+/* speedup and efficiency are relative to seq; efficiency = speedup / threads */
+int bench_run_compare(const BenchOptions* o, const BenchDriver* d) {
+    double seqAvgMs = 0.0;
+
+    bench_printf("benchmark compare game=%s kernel=%s schedule=%s section=world_update_only boids=%d size=%dx%d steps=%d\n"
+                 "  backend  threads  avg ms/tick     ticks/s  speedup  efficiency\n",
+                 d->game,
+                 boids_kernel_name(neighbor_kernel(o)),
+                 update_schedule_name(o->schedule),
+                 o->boidCount,
+                 o->width,
+                 o->height,
+                 o->benchmarkSteps);
+
+    for (int m = 0; m < UPDATER_KIND_COUNT; m++) {
+        const UpdaterKind mode = (UpdaterKind)m;
+        BenchOptions runOpt = *o;
+        BenchTarget t;
+        BenchmarkResult result;
+        double speedup;
+
+        if (!updater_ops(mode)) {
+            bench_printf("  %-7s  (not built in)\n", updater_kind_name(mode));
+            continue;
+        }
+        runOpt.mode = mode;
+        if (mode == UPDATER_SEQ) runOpt.threadCount = 1;
+        if (!d->create(d->ctx, &runOpt, &t)) {
+            return 1;
+        }
+        result = bench_run(&t, &runOpt);
+        if (mode == UPDATER_SEQ) seqAvgMs = result.avgMs;
+        speedup = result.avgMs > 0.0 ? seqAvgMs / result.avgMs : 0.0;
+
+        bench_printf("  %-7s  %7d  %11.3f  %10.2f  %6.2fx  %9.1f%%\n",
+                     updater_kind_name(mode),
+                     runOpt.threadCount,
+                     result.avgMs,
+                     result.ticksPerSecond,
+                     speedup,
+                     100.0 * speedup / (double)runOpt.threadCount);
+        if (mode != UPDATER_SEQ) bench_print_thread_stats(t.updater);
+        d->destroy(d->ctx);
+    }
+
+    return 0;
+}
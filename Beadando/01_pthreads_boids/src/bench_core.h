@@ -0,0 +1,127 @@
+#pragma once
+
+#include "boids.h"
+#include "cpu_affinity.h"
+#include "perf_counters.h"
+#include "updater.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+   Benchmark options, runner and report lines shared by boids_benchmark.exe (main.c) and the
+   headless driver (make bench). Both parse the same flags into BenchOptions, derive the world
+   seed the same way and print through the same functions, so their lines compare one to one.
+   No SDL in here: ticks are timed with profiler_now_ns.
+*/
+
+#define BENCH_DEFAULT_SEED 12345u
+#define BENCH_SIM_DT (1.0 / 120.0)
+
+enum {
+    BENCH_DEFAULT_STEPS = 500,
+    BENCH_WARMUP_STEPS = 100,
+    /* boids_rng streams of the app: the world of every reset, the survival predators */
+    BENCH_RNG_STREAM_RESET = 100,
+    BENCH_RNG_STREAM_PREDATORS = 101,
+};
+
+/* the world and updater options of a run; the game-only settings stay with the drivers */
+typedef struct BenchOptions {
+    int width;
+    int height;
+    int boidCount;
+    int threadCount;
+    UpdaterKind mode;
+    int benchmarkSteps;
+    int benchmarkWarmup;
+    BoidKernel kernel; /* resolved by bench_options_finish, never AUTO afterwards */
+    int mortonInterval;
+    bool verletLists;
+    float verletSkin;
+    bool allPairs; /* --neighbors allpairs: one grid cell, every boid against every other */
+    uint64_t seed;
+    bool seedSet;
+    int spinLimit; /* tick barrier spin rounds, -1 = updater default */
+    UpdateSchedule schedule;
+    int chunkSize;
+    bool callerWorks; /* the main thread runs one pthread part itself */
+    CpuPinMode pinMode;
+    int pinList[CPU_PIN_LIST_MAX];
+    size_t pinListCount;
+    bool batchTicks;          /* benchmark ticks run back-to-back inside the workers (update_pthreads_run) */
+    int benchTrials;          /* repeated single benchmark runs on a fresh world */
+    bool benchRejectOutliers; /* tick samples outside the Tukey fences are left out */
+    const char* benchOutPath; /* CSV, or JSON when the name ends in .json */
+    bool profile;             /* per-phase times of single benchmarks */
+    bool perfCounters;        /* hardware counters around the measured ticks (Linux) */
+} BenchOptions;
+
+typedef struct BenchmarkResult {
+    double totalMs;
+    double avgMs;
+    double ticksPerSecond;
+    unsigned long neighborRebuilds; /* Verlet list rebuilds during the measured ticks */
+    size_t tickSamples;             /* per-tick times written by bench_run_samples */
+    uint64_t candidatePairs;        /* neighbor candidates of all measured ticks (World.stepPairs) */
+} BenchmarkResult;
+
+/* a driver's world and updater, set up from the options of one run */
+typedef struct BenchTarget {
+    World* world;
+    Updater* updater;
+} BenchTarget;
+
+/* creates one run at a time; destroy tears down what the last create built */
+typedef struct BenchDriver {
+    const char* game; /* game= of the report lines */
+    void* ctx;
+    bool (*create)(void* ctx, const BenchOptions* o, BenchTarget* out);
+    void (*destroy)(void* ctx);
+} BenchDriver;
+
+int bench_parse_int(const char* s, int defaultValue);
+float bench_parse_float(const char* s, float defaultValue);
+uint64_t bench_parse_u64(const char* s, uint64_t defaultValue);
+bool bench_parse_kernel(const char* s, BoidKernel* outKernel);
+
+void bench_options_init(BenchOptions* o);
+/* 1: argv[*i] (and its value) consumed, 0: not a benchmark option, -1: bad value, reported */
+int bench_options_parse(BenchOptions* o, int argc, char** argv, int* i);
+/* range and backend checks, resolves the kernel; false after printing why */
+bool bench_options_finish(BenchOptions* o);
+void bench_print_options_usage(void);
+
+/* seed of the world built by the resetIndex-th reset of a run */
+uint64_t bench_world_seed(uint64_t seed, uint64_t resetIndex);
+UpdaterOptions bench_updater_options(const BenchOptions* o);
+/* updater_init plus --pin; pinned before world_init, so the workers first-touch the world */
+bool bench_updater_init(Updater* u, const BenchOptions* o);
+/* kernel, Morton interval and neighbor lists of a freshly initialised world */
+void bench_world_configure(World* w, const BenchOptions* o);
+
+/* report lines go to stdout and, when set, to the log file as well */
+void bench_set_log_file(FILE* f);
+void bench_write_text(const char* text);
+void bench_printf(const char* fmt, ...);
+
+/*
+   warmupSteps untimed ticks, then measureSteps timed ones. tickMs (measureSteps entries, may be
+   NULL) receives the time of every measured tick; --batch runs the ticks inside the workers,
+   so there it stays empty (tickSamples = 0).
+*/
+BenchmarkResult bench_run_samples(BenchTarget* t, const BenchOptions* o, int warmupSteps, int measureSteps, double* tickMs);
+BenchmarkResult bench_run(BenchTarget* t, const BenchOptions* o);
+/* bench_run with the counters in mask on every updater thread, summed over the measured ticks only */
+BenchmarkResult bench_run_counted(BenchTarget* t, const BenchOptions* o, unsigned mask, PerfCounterValues* total);
+
+void bench_print_result(const BenchOptions* o, const char* game, const BenchmarkResult* result);
+/* per-worker busy/idle time of the measured ticks; a balanced run has similar idle times everywhere */
+void bench_print_thread_stats(const Updater* u);
+
+/* --benchmark N with --trials, --perf, --profile and --bench-out */
+int bench_run_single(const BenchOptions* o, const BenchDriver* d);
+/* every backend built into this binary on the same seeded world, with speedup and efficiency */
+int bench_run_compare(const BenchOptions* o, const BenchDriver* d);
@@ -0,0 +1,87 @@
+#include "bench_stats.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int compare_double(const void* a, const void* b) {
+    const double x = *(const double*)a;
+    const double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* linear interpolation between the closest ranks, q in [0, 1] */
+static double sorted_quantile(const double* v, size_t n, double q) {
+    const double pos = q * (double)(n - 1);
+    const size_t i = (size_t)pos;
+    const double frac = pos - (double)i;
+
+    if (i + 1 >= n) return v[n - 1];
+    return v[i] + (v[i + 1] - v[i]) * frac;
+}
+
+static void mean_stddev(const double* v, size_t n, double* outMean, double* outStddev) {
+    double sum = 0.0;
+    double sq = 0.0;
+
+    for (size_t i = 0; i < n; i++) sum += v[i];
+    *outMean = sum / (double)n;
+    for (size_t i = 0; i < n; i++) {
+        const double d = v[i] - *outMean;
+        sq += d * d;
+    }
+    *outStddev = n > 1 ? sqrt(sq / (double)(n - 1)) : 0.0;
+}
+
+bool bench_stats_compute(const double* samples, size_t count, bool rejectOutliers, BenchStats* out) {
+    double* v;
+    size_t begin = 0;
+    size_t end = count;
+
+    if (!samples || count == 0 || !out) return false;
+    v = (double*)malloc(count * sizeof(double));
+    if (!v) return false;
+    memcpy(v, samples, count * sizeof(double));
+    qsort(v, count, sizeof(double), compare_double);
+
+    if (rejectOutliers && count >= 4) {
+        const double q1 = sorted_quantile(v, count, 0.25);
+        const double q3 = sorted_quantile(v, count, 0.75);
+        const double lo = q1 - 1.5 * (q3 - q1);
+        const double hi = q3 + 1.5 * (q3 - q1);
+
+        while (begin < end && v[begin] < lo) begin++;
+        while (end > begin && v[end - 1] > hi) end--;
+    }
+
+    out->count = end - begin;
+    out->rejected = count - out->count;
+    out->min = v[begin];
+    out->max = v[end - 1];
+    out->p50 = sorted_quantile(v + begin, out->count, 0.50);
+    out->p90 = sorted_quantile(v + begin, out->count, 0.90);
+    out->p99 = sorted_quantile(v + begin, out->count, 0.99);
+    mean_stddev(v + begin, out->count, &out->mean, &out->stddev);
+
+    free(v);
+    return true;
+}
+
+/* two-sided 95% Student t for 1..30 degrees of freedom, the normal value above */
+static double t95(size_t df) {
+    static const double table[30] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+    };
+    return df >= 1 && df <= 30 ? table[df - 1] : 1.960;
+}
+
+void bench_stats_mean_ci95(const double* values, size_t count, double* outMean, double* outHalfWidth) {
+    double mean = 0.0;
+    double stddev = 0.0;
+
+    if (count > 0) mean_stddev(values, count, &mean, &stddev);
+    if (outMean) *outMean = mean;
+    if (outHalfWidth) *outHalfWidth = count > 1 ? t95(count - 1) * stddev / sqrt((double)count) : 0.0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* summary of one sample set (per-tick times of a benchmark trial, in ms) */
+typedef struct BenchStats {
+    size_t count;    /* samples kept */
+    size_t rejected; /* samples dropped as outliers */
+    double min;
+    double p50;
+    double p90;
+    double p99;
+    double max;
+    double mean;
+    double stddev;   /* sample standard deviation (n - 1) */
+} BenchStats;
+
+/*
+   Sorts a copy of the samples. With rejectOutliers the values outside the Tukey fences
+   [Q1 - 1.5 IQR, Q3 + 1.5 IQR] are left out of every statistic. Returns false for an empty
+   set or when the copy cannot be allocated.
+*/
+bool bench_stats_compute(const double* samples, size_t count, bool rejectOutliers, BenchStats* out);
+
+/* mean and the half width of its 95% confidence interval (Student t); the width is 0 below 2 values */
+void bench_stats_mean_ci95(const double* values, size_t count, double* outMean, double* outHalfWidth);
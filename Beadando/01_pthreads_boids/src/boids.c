@@ -1,19 +1,39 @@
 #include "boids.h"
+#include "boids_kernel.h"
 
 #include <math.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
-static float frand01(void) {
-    return (float)rand() / (float)RAND_MAX;
+static uint64_t splitmix64_mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
 }
 
-static float frand_range(float a, float b) {
-    return a + (b - a) * frand01();
+uint64_t boids_rng_u64(uint64_t seed, uint64_t stream, uint64_t index) {
+    const uint64_t gamma = 0x9E3779B97F4A7C15ull;
+    uint64_t key = splitmix64_mix(seed + gamma * (stream + 1));
+    return splitmix64_mix(key + gamma * (index + 1));
 }
 
-static float frand_signed(void) {
-    return frand01() * 2.0f - 1.0f;
+float boids_rng_float01(uint64_t seed, uint64_t stream, uint64_t index) {
+    return (float)(boids_rng_u64(seed, stream, index) >> 40) * (1.0f / 16777216.0f);
+}
+
+enum {
+    RNG_STREAM_GROUPS = 1,
+    RNG_STREAM_BOIDS = 2,
+    RNG_DRAWS_PER_BOID = 8,
+};
+
+static float rng_range(uint64_t seed, uint64_t stream, uint64_t index, float a, float b) {
+    return a + (b - a) * boids_rng_float01(seed, stream, index);
+}
+
+static float rng_signed(uint64_t seed, uint64_t stream, uint64_t index) {
+    return boids_rng_float01(seed, stream, index) * 2.0f - 1.0f;
 }
 
 static Vec2 v_add(Vec2 a, Vec2 b) { return (Vec2){a.x + b.x, a.y + b.y}; }
@@ -64,42 +84,283 @@ static Vec2 steer_towards(Vec2 desiredVel, Vec2 currentVel, float maxForce) {
     return v_limit(steer, maxForce);
 }
 
-bool world_init(World* w, int width, int height, size_t boidCount) {
+#define BOID_ARRAY_ALIGN 64u
+
+static size_t align_up(size_t n) {
+    return (n + (BOID_ARRAY_ALIGN - 1u)) & ~(size_t)(BOID_ARRAY_ALIGN - 1u);
+}
+
+static bool boid_arrays_alloc(BoidArrays* a, size_t count) {
+    const size_t floatBytes = align_up(count * sizeof(float));
+    const size_t byteBytes = align_up(count);
+    unsigned char* base;
+
+    memset(a, 0, sizeof(*a));
+    a->block = calloc(1, 4 * floatBytes + 2 * byteBytes + BOID_ARRAY_ALIGN);
+    if (!a->block) return false;
+
+    base = (unsigned char*)a->block;
+    base += (BOID_ARRAY_ALIGN - (uintptr_t)base % BOID_ARRAY_ALIGN) % BOID_ARRAY_ALIGN;
+    a->x = (float*)base;
+    a->y = (float*)(base + floatBytes);
+    a->vx = (float*)(base + 2 * floatBytes);
+    a->vy = (float*)(base + 3 * floatBytes);
+    a->group = base + 4 * floatBytes;
+    a->flags = base + 4 * floatBytes + byteBytes;
+    return true;
+}
+
+static void boid_arrays_free(BoidArrays* a) {
+    free(a->block);
+    memset(a, 0, sizeof(*a));
+}
+
+/*
+   Must not be smaller than the largest radius searched through the grid. Predators are not
+   in the grid (their avoid radius is handled via World.predators), so that is the neighbor radius.
+*/
+#define GRID_MIN_CELL_SIZE BOIDS_NEIGHBOR_RADIUS
+
+/* the list build scans the 3x3 cells too, so with Verlet lists the cells also cover the skin */
+static float grid_cell_size(const World* w) {
+    if (w->lists.enabled) return GRID_MIN_CELL_SIZE + w->lists.skin;
+    return GRID_MIN_CELL_SIZE;
+}
+
+static bool grid_init(BoidGrid* g, size_t boidCount) {
+    memset(g, 0, sizeof(*g));
+    g->cellStart = (size_t*)calloc(2, sizeof(size_t));
+    g->cellBoids = (size_t*)calloc(boidCount, sizeof(size_t));
+    g->boidCell = (size_t*)calloc(boidCount, sizeof(size_t));
+    g->boidSlot = (size_t*)calloc(boidCount, sizeof(size_t));
+    if (!g->cellStart || !g->cellBoids || !g->boidCell || !g->boidSlot ||
+        !boid_arrays_alloc(&g->packed, boidCount + BOIDS_SIMD_PAD)) {
+        free(g->cellStart);
+        free(g->cellBoids);
+        free(g->boidCell);
+        free(g->boidSlot);
+        memset(g, 0, sizeof(*g));
+        return false;
+    }
+    g->cellCapacity = 1;
+    g->cols = 1;
+    g->rows = 1;
+    return true;
+}
+
+static void grid_destroy(BoidGrid* g) {
+    free(g->cellStart);
+    free(g->cellBoids);
+    free(g->boidCell);
+    free(g->boidSlot);
+    boid_arrays_free(&g->packed);
+    memset(g, 0, sizeof(*g));
+}
+
+static bool grid_reserve_cells(BoidGrid* g, size_t cellCount) {
+    size_t* cellStart;
+
+    if (cellCount <= g->cellCapacity) return true;
+
+    cellStart = (size_t*)realloc(g->cellStart, (cellCount + 1) * sizeof(size_t));
+    if (!cellStart) return false;
+    g->cellStart = cellStart;
+    g->cellCapacity = cellCount;
+    return true;
+}
+
+static void grid_dims(const World* w, int* cols, int* rows) {
+    *cols = 1;
+    *rows = 1;
+    if (w->useGrid) {
+        *cols = (int)((float)w->width / grid_cell_size(w));
+        *rows = (int)((float)w->height / grid_cell_size(w));
+        if (*cols < 1) *cols = 1;
+        if (*rows < 1) *rows = 1;
+    }
+}
+
+static size_t grid_cell_of(const BoidGrid* g, Vec2 p) {
+    int cx = (int)(p.x / g->cellW);
+    int cy = (int)(p.y / g->cellH);
+
+    if (cx < 0) cx = 0;
+    else if (cx >= g->cols) cx = g->cols - 1;
+    if (cy < 0) cy = 0;
+    else if (cy >= g->rows) cy = g->rows - 1;
+
+    return (size_t)cy * (size_t)g->cols + (size_t)cx;
+}
+
+/* neighboring cell indices along one axis; narrow grids list every cell once so nothing is visited twice */
+static int grid_axis_span(int c, int count, int out[3]) {
+    if (count < 3) {
+        for (int k = 0; k < count; k++) out[k] = k;
+        return count;
+    }
+    out[0] = (c == 0) ? count - 1 : c - 1;
+    out[1] = c;
+    out[2] = (c == count - 1) ? 0 : c + 1;
+    return 3;
+}
+
+static void morton_sort_free(MortonSort* ms) {
+    free(ms->keys);
+    free(ms->keysTmp);
+    free(ms->order);
+    free(ms->orderTmp);
+    free(ms->idTmp);
+    free(ms->histogram);
+    memset(ms, 0, sizeof(*ms));
+}
+
+static bool morton_sort_reserve(MortonSort* ms, size_t count, size_t parts) {
+    if (count > ms->capacity) {
+        morton_sort_free(ms);
+        ms->keys = (uint32_t*)malloc(count * sizeof(uint32_t));
+        ms->keysTmp = (uint32_t*)malloc(count * sizeof(uint32_t));
+        ms->order = (uint32_t*)malloc(count * sizeof(uint32_t));
+        ms->orderTmp = (uint32_t*)malloc(count * sizeof(uint32_t));
+        ms->idTmp = (size_t*)malloc(count * sizeof(size_t));
+        if (!ms->keys || !ms->keysTmp || !ms->order || !ms->orderTmp || !ms->idTmp) {
+            morton_sort_free(ms);
+            return false;
+        }
+        ms->capacity = count;
+    }
+    if (parts > ms->histogramParts) {
+        size_t* histogram = (size_t*)realloc(ms->histogram, parts * 256 * sizeof(size_t));
+        if (!histogram) return false;
+        ms->histogram = histogram;
+        ms->histogramParts = parts;
+    }
+    return true;
+}
+
+static void neighbor_lists_free(NeighborLists* nl) {
+    free(nl->start);
+    free(nl->items);
+    free(nl->refX);
+    free(nl->refY);
+    memset(nl, 0, sizeof(*nl));
+}
+
+static void part_range(size_t count, size_t part, size_t partCount, size_t* begin, size_t* end) {
+    *begin = (count * part) / partCount;
+    *end = (count * (part + 1)) / partCount;
+}
+
+static size_t world_parallel_parts(const WorldParallel* par) {
+    return (par && par->run && par->partCount > 1) ? par->partCount : 1;
+}
+
+static void world_parallel_run(const WorldParallel* par, WorldPartFn fn, void* arg) {
+    if (world_parallel_parts(par) == 1) {
+        fn(arg, 0, 1);
+        return;
+    }
+    par->run(par->ctx, fn, arg);
+}
+
+typedef struct InitJob {
+    World* w;
+    uint64_t seed;
+    Vec2 centers[16];
+    Vec2 dirs[16];
+} InitJob;
+
+/* every draw is keyed by (seed, boid index), so the result does not depend on the partitioning */
+static void init_boids_part(void* arg, size_t part, size_t partCount) {
+    InitJob* job = (InitJob*)arg;
+    World* w = job->w;
+    const float baseSpeed = 14.0f;
+    const float width = (float)w->width;
+    const float height = (float)w->height;
+    size_t begin;
+    size_t end;
+
+    part_range(w->boidCount, part, partCount, &begin, &end);
+    for (size_t i = begin; i < end; i++) {
+        const uint64_t r = (uint64_t)i * RNG_DRAWS_PER_BOID;
+        /* balanced: round-robin groups */
+        int g = (int)(i % (size_t)w->groupCount);
+        float sizeFactor = 1.0f;
+
+        float spreadX = width * (0.03f + 0.04f * sizeFactor);
+        float spreadY = height * (0.04f + 0.06f * sizeFactor);
+        Vec2 p = v_add(job->centers[g], (Vec2){rng_signed(job->seed, RNG_STREAM_BOIDS, r) * spreadX,
+                                               rng_signed(job->seed, RNG_STREAM_BOIDS, r + 1) * spreadY});
+        p = wrap_pos(w, p);
+        w->boids.x[i] = p.x;
+        w->boids.y[i] = p.y;
+        w->boids.group[i] = (unsigned char)g;
+        w->boids.flags[i] = BOID_FLAG_ALIVE;
+        w->boidId[i] = i;
+
+        float sp = baseSpeed + rng_signed(job->seed, RNG_STREAM_BOIDS, r + 2) * (3.0f + 2.0f * sizeFactor);
+        Vec2 jitterDir = v_norm((Vec2){job->dirs[g].x + rng_signed(job->seed, RNG_STREAM_BOIDS, r + 3) * 0.30f,
+                                       job->dirs[g].y + rng_signed(job->seed, RNG_STREAM_BOIDS, r + 4) * 0.30f});
+        Vec2 v = v_mul(jitterDir, sp);
+        w->boids.vx[i] = v.x;
+        w->boids.vy[i] = v.y;
+
+        /* first touch: the pages of both buffers land on the NUMA node of the thread owning this slice */
+        w->boidsNext.x[i] = p.x;
+        w->boidsNext.y[i] = p.y;
+        w->boidsNext.vx[i] = v.x;
+        w->boidsNext.vy[i] = v.y;
+        w->boidsNext.group[i] = (unsigned char)g;
+        w->boidsNext.flags[i] = BOID_FLAG_ALIVE;
+        w->stepCost[i] = 0;
+    }
+}
+
+bool world_init(World* w, int width, int height, size_t boidCount, uint64_t seed, const WorldParallel* par) {
+    InitJob job;
+
     memset(w, 0, sizeof(*w));
     w->width = width;
     w->height = height;
     w->groupCount = 1;
     w->boidCount = boidCount;
 
-    w->boids = (Boid*)calloc(boidCount, sizeof(Boid));
-    w->boidsNext = (Boid*)calloc(boidCount, sizeof(Boid));
-    if (!w->boids || !w->boidsNext) {
-        free(w->boids);
-        free(w->boidsNext);
+    if (!boid_arrays_alloc(&w->boids, boidCount) || !boid_arrays_alloc(&w->boidsNext, boidCount) ||
+        !grid_init(&w->grid, boidCount) || !(w->boidId = (size_t*)calloc(boidCount ? boidCount : 1, sizeof(size_t))) ||
+        !(w->predators = (size_t*)calloc(boidCount ? boidCount : 1, sizeof(size_t))) ||
+        !(w->stepCost = (uint32_t*)calloc(boidCount ? boidCount : 1, sizeof(uint32_t)))) {
+        boid_arrays_free(&w->boids);
+        boid_arrays_free(&w->boidsNext);
+        grid_destroy(&w->grid);
+        free(w->boidId);
+        free(w->predators);
         return false;
     }
+    w->useGrid = true;
+    w->kernel = boids_best_kernel();
 
     int groupCount = (int)(boidCount / 60);
     if (groupCount < 6) groupCount = 6;
     if (groupCount > 16) groupCount = 16;
     w->groupCount = groupCount;
 
-    Vec2 centers[16];
-    Vec2 dirs[16];
+    memset(&job, 0, sizeof(job));
+    job.w = w;
+    job.seed = seed;
 
     for (int g = 0; g < groupCount; g++) {
         /* choose separated group centers so we don't get one huge blob */
+        const uint64_t r = (uint64_t)g * 128u;
         Vec2 c = {0, 0};
         const float minD2 = (float)(width * width + height * height) * 0.02f;
         for (int tries = 0; tries < 60; tries++) {
             c = (Vec2){
-                frand_range(0.10f * (float)width, 0.90f * (float)width),
-                frand_range(0.10f * (float)height, 0.90f * (float)height),
+                rng_range(seed, RNG_STREAM_GROUPS, r + 2u * (uint64_t)tries, 0.10f * (float)width, 0.90f * (float)width),
+                rng_range(seed, RNG_STREAM_GROUPS, r + 2u * (uint64_t)tries + 1u, 0.10f * (float)height, 0.90f * (float)height),
             };
             bool ok = true;
             for (int k = 0; k < g; k++) {
-                float dx = torus_delta(c.x - centers[k].x, (float)width);
-                float dy = torus_delta(c.y - centers[k].y, (float)height);
+                float dx = torus_delta(c.x - job.centers[k].x, (float)width);
+                float dy = torus_delta(c.y - job.centers[k].y, (float)height);
                 float d2 = dx * dx + dy * dy;
                 if (d2 < minD2) {
                     ok = false;
@@ -108,45 +369,91 @@ bool world_init(World* w, int width, int height, size_t boidCount) {
             }
             if (ok) break;
         }
-        centers[g] = c;
+        job.centers[g] = c;
 
-        float a = frand_range(0.0f, 6.2831853f);
-        dirs[g] = (Vec2){cosf(a), sinf(a)};
+        float a = rng_range(seed, RNG_STREAM_GROUPS, r + 127u, 0.0f, 6.2831853f);
+        job.dirs[g] = (Vec2){cosf(a), sinf(a)};
     }
 
-    const float baseSpeed = 14.0f;
-
-    for (size_t i = 0; i < boidCount; i++) {
-        /* balanced: round-robin groups */
-        int g = (int)(i % (size_t)groupCount);
-        float sizeFactor = 1.0f;
-
-        float spreadX = (float)width * (0.03f + 0.04f * sizeFactor);
-        float spreadY = (float)height * (0.04f + 0.06f * sizeFactor);
-        Vec2 p = v_add(centers[g], (Vec2){frand_signed() * spreadX, frand_signed() * spreadY});
-        p = wrap_pos(w, p);
-        w->boids[i].pos = p;
-        w->boids[i].group = (unsigned char)g;
-        w->boids[i].alive = 1;
-        w->boids[i].predator = 0;
-
-        float sp = baseSpeed + frand_signed() * (3.0f + 2.0f * sizeFactor);
-        Vec2 jitterDir = v_norm((Vec2){dirs[g].x + frand_signed() * 0.30f, dirs[g].y + frand_signed() * 0.30f});
-        w->boids[i].vel = v_mul(jitterDir, sp);
-    }
+    world_parallel_run(par, init_boids_part, &job);
 
     w->player.pos = (Vec2){(float)(width / 2), (float)(height / 2)};
     w->player.speed = 25.0f;
+    world_prepare_step(w, par);
     return true;
 }
 
 void world_destroy(World* w) {
     if (!w) return;
-    free(w->boids);
-    free(w->boidsNext);
+    boid_arrays_free(&w->boids);
+    boid_arrays_free(&w->boidsNext);
+    grid_destroy(&w->grid);
+    morton_sort_free(&w->sort);
+    neighbor_lists_free(&w->lists);
+    free(w->boidId);
+    free(w->predators);
+    free(w->stepCost);
     memset(w, 0, sizeof(*w));
 }
 
+void world_update_population(World* w) {
+    w->predatorCount = 0;
+    w->deadCount = 0;
+    for (size_t i = 0; i < w->boidCount; i++) {
+        if (!(w->boids.flags[i] & BOID_FLAG_ALIVE)) w->deadCount++;
+        if (w->boids.flags[i] & BOID_FLAG_PREDATOR) w->predators[w->predatorCount++] = i;
+    }
+    w->stepVariant = (w->predatorCount > 0 ? 1 : 0) | (w->deadCount > 0 ? 2 : 0);
+}
+
+size_t world_compact_dead(World* w) {
+    BoidArrays* a = &w->boids;
+    size_t live = 0;
+    size_t removed;
+
+    for (size_t i = 0; i < w->boidCount; i++) {
+        if (!(a->flags[i] & BOID_FLAG_ALIVE)) continue;
+        if (live != i) {
+            a->x[live] = a->x[i];
+            a->y[live] = a->y[i];
+            a->vx[live] = a->vx[i];
+            a->vy[live] = a->vy[i];
+            a->group[live] = a->group[i];
+            a->flags[live] = a->flags[i];
+            w->boidId[live] = w->boidId[i];
+        }
+        live++;
+    }
+
+    /* boidsNext needs no compaction, the next step rewrites all of [0, boidCount) */
+    removed = w->boidCount - live;
+    if (removed > 0) {
+        w->boidCount = live;
+        w->lists.valid = false;
+        w->stepCostValid = false;
+    }
+    world_update_population(w);
+    return removed;
+}
+
+void world_set_size(World* w, int width, int height) {
+    if (w->width == width && w->height == height) return;
+    w->width = width;
+    w->height = height;
+    if (w->width > 0) {
+        float fw = (float)w->width;
+        while (w->player.pos.x >= fw) w->player.pos.x -= fw;
+        while (w->player.pos.x < 0) w->player.pos.x += fw;
+    }
+    if (w->height > 0) {
+        float fh = (float)w->height;
+        while (w->player.pos.y >= fh) w->player.pos.y -= fh;
+        while (w->player.pos.y < 0) w->player.pos.y += fh;
+    }
+    w->lists.valid = false;
+    w->stepCostValid = false;
+}
+
 void world_apply_player_input(World* w, const InputState* in, double dt) {
     Vec2 d = {0, 0};
     if (in->up) d.y -= 1;
@@ -160,11 +467,564 @@ void world_apply_player_input(World* w, const InputState* in, double dt) {
         w->player.pos = wrap_pos(w, w->player.pos);
     }
 }
-void world_step_range(const World* r, World* w, size_t begin, size_t end, double dt) {
 
-    const float neighborRadius = 6.5f;
-    const float desiredSeparation = 2.2f;
-    const float desiredSeparation2 = desiredSeparation * desiredSeparation;
+typedef struct ShockJob {
+    World* w;
+    float radius;
+    float strength;
+} ShockJob;
+
+static void shockwave_part(void* arg, size_t part, size_t partCount) {
+    const ShockJob* job = (const ShockJob*)arg;
+    World* w = job->w;
+    const float ww = (float)w->width;
+    const float hh = (float)w->height;
+    const float r2 = job->radius * job->radius;
+    const float eps = 1e-6f;
+    size_t begin;
+    size_t end;
+
+    part_range(w->boidCount, part, partCount, &begin, &end);
+    for (size_t i = begin; i < end; i++) {
+        if (!(w->boids.flags[i] & BOID_FLAG_ALIVE)) continue;
+
+        float dx = torus_delta(w->boids.x[i] - w->player.pos.x, ww);
+        float dy = torus_delta(w->boids.y[i] - w->player.pos.y, hh);
+        float d2 = dx * dx + dy * dy;
+        if (d2 >= r2 || d2 < eps) continue;
+
+        float d = sqrtf(d2);
+        float t = (job->radius - d) / job->radius;
+        /* impulse (not acceleration): make it feel immediate */
+        float k = (job->strength * t);
+        w->boids.vx[i] += (dx / d) * k;
+        w->boids.vy[i] += (dy / d) * k;
+    }
+}
+
+/*
+   The impulse has to land before the step reads the velocities (its own and as a neighbor),
+   so this stays a pass of its own; every boid is independent, so it splits like the step.
+*/
+void world_apply_shockwave(World* w, float radius, float strength, const WorldParallel* par) {
+    ShockJob job = {w, radius, strength};
+
+    if (!w) return;
+    if (radius <= 0.0f || strength <= 0.0f) return;
+    world_parallel_run(par, shockwave_part, &job);
+}
+
+static void grid_build(World* w) {
+    BoidGrid* g = &w->grid;
+    int cols;
+    int rows;
+    size_t cellCount;
+
+    grid_dims(w, &cols, &rows);
+    if (!grid_reserve_cells(g, (size_t)cols * (size_t)rows)) {
+        /* a single cell degrades to the plain all-pairs scan */
+        cols = 1;
+        rows = 1;
+    }
+
+    g->cols = cols;
+    g->rows = rows;
+    g->cellW = (float)w->width / (float)cols;
+    g->cellH = (float)w->height / (float)rows;
+    cellCount = (size_t)cols * (size_t)rows;
+
+    /* counting sort: count, exclusive prefix, scatter, then shift the cursors back into starts */
+    memset(g->cellStart, 0, (cellCount + 1) * sizeof(size_t));
+    for (size_t i = 0; i < w->boidCount; i++) {
+        if (!(w->boids.flags[i] & BOID_FLAG_ALIVE)) {
+            g->boidCell[i] = cellCount;
+            continue;
+        }
+        g->boidCell[i] = grid_cell_of(g, (Vec2){w->boids.x[i], w->boids.y[i]});
+        if (w->boids.flags[i] & BOID_FLAG_PREDATOR) continue;
+        g->cellStart[g->boidCell[i]]++;
+    }
+
+    {
+        size_t sum = 0;
+        for (size_t c = 0; c < cellCount; c++) {
+            size_t count = g->cellStart[c];
+            g->cellStart[c] = sum;
+            sum += count;
+        }
+    }
+
+    for (size_t i = 0; i < w->boidCount; i++) {
+        size_t c = g->boidCell[i];
+        if (c == cellCount || (w->boids.flags[i] & BOID_FLAG_PREDATOR)) {
+            g->boidSlot[i] = SIZE_MAX;
+            continue;
+        }
+        size_t k = g->cellStart[c]++;
+        g->cellBoids[k] = i;
+        g->boidSlot[i] = k;
+        g->packed.x[k] = w->boids.x[i];
+        g->packed.y[k] = w->boids.y[i];
+        g->packed.vx[k] = w->boids.vx[i];
+        g->packed.vy[k] = w->boids.vy[i];
+        g->packed.group[k] = w->boids.group[i];
+        g->packed.flags[k] = w->boids.flags[i];
+    }
+
+    memmove(g->cellStart + 1, g->cellStart, cellCount * sizeof(size_t));
+    g->cellStart[0] = 0;
+}
+
+bool world_set_neighbor_lists(World* w, bool enabled, float skin) {
+    NeighborLists* nl = &w->lists;
+
+    nl->valid = false;
+    nl->enabled = false;
+    if (!enabled) return true;
+    if (skin < 0.0f) skin = 0.0f;
+
+    if (!nl->start) {
+        nl->start = (size_t*)calloc(w->boidCount + 1, sizeof(size_t));
+        nl->refX = (float*)calloc(w->boidCount ? w->boidCount : 1, sizeof(float));
+        nl->refY = (float*)calloc(w->boidCount ? w->boidCount : 1, sizeof(float));
+        if (!nl->start || !nl->refX || !nl->refY) {
+            neighbor_lists_free(nl);
+            return false;
+        }
+    }
+    nl->skin = skin;
+    nl->enabled = true;
+    nl->rebuilds = 0;
+    nl->ticks = 0;
+    return true;
+}
+
+/* true once any alive boid has moved more than skin / 2 since the last build */
+static bool neighbor_lists_stale(const World* w) {
+    const NeighborLists* nl = &w->lists;
+    const float limit = 0.5f * nl->skin;
+    const float limit2 = limit * limit;
+    const float worldW = (float)w->width;
+    const float worldH = (float)w->height;
+
+    for (size_t i = 0; i < w->boidCount; i++) {
+        if (!(w->boids.flags[i] & BOID_FLAG_ALIVE)) continue;
+        float dx = torus_delta(w->boids.x[i] - nl->refX[i], worldW);
+        float dy = torus_delta(w->boids.y[i] - nl->refY[i], worldH);
+        if (dx * dx + dy * dy > limit2) return true;
+    }
+    return false;
+}
+
+/* candidates of boid i from the grid; only counts when out is NULL */
+static size_t neighbor_scan(const World* w, size_t i, uint32_t* out) {
+    const BoidGrid* g = &w->grid;
+    const BoidArrays* packed = &g->packed;
+    const float skin = w->lists.skin;
+    const bool predator = (w->boids.flags[i] & BOID_FLAG_PREDATOR) != 0;
+    const float groupR = BOIDS_NEIGHBOR_RADIUS + skin;
+    /* predators separate from everyone within their own (larger) radius */
+    const float otherR = (predator ? BOIDS_PRED_SEP_RADIUS : BOIDS_SEPARATION_RADIUS) + skin;
+    const unsigned char group = w->boids.group[i];
+    const float worldW = (float)w->width;
+    const float worldH = (float)w->height;
+    const size_t cell = g->boidCell[i];
+    const size_t self = g->boidSlot[i];
+    const float px = w->boids.x[i];
+    const float py = w->boids.y[i];
+    int spanX[3];
+    int spanY[3];
+    const int nx = grid_axis_span((int)(cell % (size_t)g->cols), g->cols, spanX);
+    const int ny = grid_axis_span((int)(cell / (size_t)g->cols), g->rows, spanY);
+    size_t n = 0;
+
+    for (int cy = 0; cy < ny; cy++) {
+        for (int cx = 0; cx < nx; cx++) {
+            const size_t c = (size_t)spanY[cy] * (size_t)g->cols + (size_t)spanX[cx];
+            for (size_t k = g->cellStart[c]; k < g->cellStart[c + 1]; k++) {
+                if (k == self) continue;
+
+                float dx = torus_delta(packed->x[k] - px, worldW);
+                float dy = torus_delta(packed->y[k] - py, worldH);
+                /* other groups only matter for separation */
+                float r = (packed->group[k] == group) ? groupR : otherR;
+                if (dx * dx + dy * dy >= r * r) continue;
+                if (out) out[n] = (uint32_t)g->cellBoids[k];
+                n++;
+            }
+        }
+    }
+    return n;
+}
+
+static void neighbor_count_part(void* arg, size_t part, size_t partCount) {
+    World* w = (World*)arg;
+    NeighborLists* nl = &w->lists;
+    size_t begin;
+    size_t end;
+
+    part_range(w->boidCount, part, partCount, &begin, &end);
+    for (size_t i = begin; i < end; i++) {
+        nl->refX[i] = w->boids.x[i];
+        nl->refY[i] = w->boids.y[i];
+        nl->start[i + 1] = (w->boids.flags[i] & BOID_FLAG_ALIVE) ? neighbor_scan(w, i, NULL) : 0;
+    }
+}
+
+static void neighbor_fill_part(void* arg, size_t part, size_t partCount) {
+    World* w = (World*)arg;
+    NeighborLists* nl = &w->lists;
+    size_t begin;
+    size_t end;
+
+    part_range(w->boidCount, part, partCount, &begin, &end);
+    for (size_t i = begin; i < end; i++) {
+        if (nl->start[i + 1] == nl->start[i]) continue;
+        (void)neighbor_scan(w, i, nl->items + nl->start[i]);
+    }
+}
+
+static bool neighbor_lists_build(World* w, const WorldParallel* par) {
+    NeighborLists* nl = &w->lists;
+    size_t total;
+
+    world_parallel_run(par, neighbor_count_part, w);
+
+    nl->start[0] = 0;
+    for (size_t i = 0; i < w->boidCount; i++) {
+        nl->start[i + 1] += nl->start[i];
+    }
+    total = nl->start[w->boidCount];
+
+    if (total > nl->itemCapacity) {
+        size_t capacity = nl->itemCapacity + nl->itemCapacity / 2;
+        uint32_t* items;
+        if (capacity < total) capacity = total;
+        items = (uint32_t*)realloc(nl->items, capacity * sizeof(uint32_t));
+        if (!items) return false;
+        nl->items = items;
+        nl->itemCapacity = capacity;
+    }
+
+    world_parallel_run(par, neighbor_fill_part, w);
+    return true;
+}
+
+void world_prepare_step(World* w, const WorldParallel* par) {
+    NeighborLists* nl = &w->lists;
+
+    if (nl->enabled) {
+        nl->ticks++;
+        if (nl->valid && !neighbor_lists_stale(w)) return;
+    }
+
+    grid_build(w);
+
+    if (nl->enabled) {
+        /* on allocation failure the step falls back to the grid built above */
+        nl->valid = neighbor_lists_build(w, par);
+        if (nl->valid) nl->rebuilds++;
+    }
+}
+
+/* one prey candidate of the prey neighbor loop, shared by the grid span and the Verlet list walk */
+static inline void prey_accumulate(PreySums* sums, float dx, float dy, unsigned char group,
+                                   float vx, float vy, unsigned char selfGroup) {
+    const float desiredSeparation2 = BOIDS_SEPARATION_RADIUS * BOIDS_SEPARATION_RADIUS;
+    const float neighborRadius2 = BOIDS_NEIGHBOR_RADIUS * BOIDS_NEIGHBOR_RADIUS;
+    float d2 = dx * dx + dy * dy;
+
+    /* separation against everyone */
+    if (d2 < desiredSeparation2 && d2 > BOIDS_MIN_DIST2) {
+        Vec2 diff = (Vec2){dx, dy};
+        Vec2 away = v_mul(v_norm(diff), -1.0f);
+        sums->sep = v_add(sums->sep, v_div(away, sqrtf(d2)));
+    }
+
+    /* cohesion/alignment only within the same group */
+    if (group != selfGroup) return;
+    if (d2 < neighborRadius2) {
+        sums->neighbors++;
+        sums->offset = v_add(sums->offset, (Vec2){dx, dy});
+        sums->vel = v_add(sums->vel, (Vec2){vx, vy});
+    }
+}
+
+static inline void predator_separate(Vec2* sumSep, float dx, float dy, float radius2) {
+    float d2 = dx * dx + dy * dy;
+    if (d2 < radius2 && d2 > BOIDS_MIN_DIST2) {
+        Vec2 diff = (Vec2){dx, dy};
+        Vec2 away = v_mul(v_norm(diff), -1.0f);
+        *sumSep = v_add(*sumSep, v_div(away, sqrtf(d2)));
+    }
+}
+
+/* a predator seen by a prey boid: separation like any boid, plus the wider avoidance */
+static inline void prey_avoid_predator(PreySums* sums, Vec2* sumPred, float dx, float dy) {
+    const float desiredSeparation2 = BOIDS_SEPARATION_RADIUS * BOIDS_SEPARATION_RADIUS;
+    const float predAvoidRadius2 = BOIDS_PRED_AVOID_RADIUS * BOIDS_PRED_AVOID_RADIUS;
+    float d2 = dx * dx + dy * dy;
+
+    if (d2 >= predAvoidRadius2 || d2 <= BOIDS_MIN_DIST2) return;
+
+    Vec2 away = v_div(v_mul(v_norm((Vec2){dx, dy}), -1.0f), sqrtf(d2));
+    if (d2 < desiredSeparation2) sums->sep = v_add(sums->sep, away);
+    *sumPred = v_add(*sumPred, away);
+}
+
+static void prey_span_scalar(const BoidArrays* p, size_t begin, size_t end, size_t self,
+                             Vec2 pos, unsigned char group, float worldW, float worldH, PreySums* sums) {
+    for (size_t k = begin; k < end; k++) {
+        if (k == self) continue;
+
+        float dx = torus_delta(p->x[k] - pos.x, worldW);
+        float dy = torus_delta(p->y[k] - pos.y, worldH);
+        prey_accumulate(sums, dx, dy, p->group[k], p->vx[k], p->vy[k], group);
+    }
+}
+
+/* Verlet list variant: candidates are boid indices into the current buffer, some may have died since the build */
+static BOIDS_FORCE_INLINE void prey_list_scalar(const BoidArrays* in, const uint32_t* items, size_t count,
+                                                Vec2 pos, unsigned char group, float worldW, float worldH,
+                                                PreySums* sums, const bool hasDead) {
+    for (size_t k = 0; k < count; k++) {
+        const size_t j = items[k];
+        if (hasDead && !(in->flags[j] & BOID_FLAG_ALIVE)) continue;
+
+        float dx = torus_delta(in->x[j] - pos.x, worldW);
+        float dy = torus_delta(in->y[j] - pos.y, worldH);
+        prey_accumulate(sums, dx, dy, in->group[j], in->vx[j], in->vy[j], group);
+    }
+}
+
+static PreySpanFn prey_span_for(BoidKernel kernel) {
+    switch (kernel) {
+    case BOID_KERNEL_AVX2: return prey_span_avx2;
+    case BOID_KERNEL_SSE2: return prey_span_sse2;
+    default: return prey_span_scalar;
+    }
+}
+
+BoidKernel boids_best_kernel(void) {
+    if (boids_cpu_has_avx2()) return BOID_KERNEL_AVX2;
+    if (boids_cpu_has_sse2()) return BOID_KERNEL_SSE2;
+    return BOID_KERNEL_SCALAR;
+}
+
+bool boids_kernel_supported(BoidKernel kernel) {
+    switch (kernel) {
+    case BOID_KERNEL_AUTO:
+    case BOID_KERNEL_SCALAR: return true;
+    case BOID_KERNEL_SSE2: return boids_cpu_has_sse2();
+    case BOID_KERNEL_AVX2: return boids_cpu_has_avx2();
+    }
+    return false;
+}
+
+const char* boids_kernel_name(BoidKernel kernel) {
+    switch (kernel) {
+    case BOID_KERNEL_AUTO: return "auto";
+    case BOID_KERNEL_SCALAR: return "scalar";
+    case BOID_KERNEL_SSE2: return "sse2";
+    case BOID_KERNEL_AVX2: return "avx2";
+    }
+    return "?";
+}
+
+bool world_set_kernel(World* w, BoidKernel kernel) {
+    if (!boids_kernel_supported(kernel)) return false;
+    w->kernel = (kernel == BOID_KERNEL_AUTO) ? boids_best_kernel() : kernel;
+    return true;
+}
+
+/* spreads the low 16 bits to the even bit positions */
+static uint32_t morton_spread(uint32_t v) {
+    v &= 0xFFFFu;
+    v = (v | (v << 8)) & 0x00FF00FFu;
+    v = (v | (v << 4)) & 0x0F0F0F0Fu;
+    v = (v | (v << 2)) & 0x33333333u;
+    v = (v | (v << 1)) & 0x55555555u;
+    return v;
+}
+
+static int bit_width(uint32_t v) {
+    int bits = 0;
+    while (v >> bits) bits++;
+    return bits;
+}
+
+typedef struct MortonJob {
+    World* w;
+    int cols;
+    int rows;
+    float cellW;
+    float cellH;
+    uint32_t deadKey;
+    int shift;
+    const uint32_t* srcKeys;
+    const uint32_t* srcOrder;
+    uint32_t* dstKeys;
+    uint32_t* dstOrder;
+} MortonJob;
+
+static void morton_keys_part(void* arg, size_t part, size_t partCount) {
+    MortonJob* job = (MortonJob*)arg;
+    World* w = job->w;
+    size_t begin;
+    size_t end;
+
+    part_range(w->boidCount, part, partCount, &begin, &end);
+    for (size_t i = begin; i < end; i++) {
+        uint32_t key = job->deadKey;
+        if (w->boids.flags[i] & BOID_FLAG_ALIVE) {
+            int cx = (int)(w->boids.x[i] / job->cellW);
+            int cy = (int)(w->boids.y[i] / job->cellH);
+            if (cx < 0) cx = 0;
+            else if (cx >= job->cols) cx = job->cols - 1;
+            if (cy < 0) cy = 0;
+            else if (cy >= job->rows) cy = job->rows - 1;
+            key = morton_spread((uint32_t)cx) | (morton_spread((uint32_t)cy) << 1);
+        }
+        w->sort.keys[i] = key;
+        w->sort.order[i] = (uint32_t)i;
+    }
+}
+
+static void morton_count_part(void* arg, size_t part, size_t partCount) {
+    MortonJob* job = (MortonJob*)arg;
+    size_t* hist = job->w->sort.histogram + part * 256;
+    size_t begin;
+    size_t end;
+
+    memset(hist, 0, 256 * sizeof(size_t));
+    part_range(job->w->boidCount, part, partCount, &begin, &end);
+    for (size_t i = begin; i < end; i++) {
+        hist[(job->srcKeys[i] >> job->shift) & 0xFFu]++;
+    }
+}
+
+static void morton_scatter_part(void* arg, size_t part, size_t partCount) {
+    MortonJob* job = (MortonJob*)arg;
+    size_t* cursor = job->w->sort.histogram + part * 256;
+    size_t begin;
+    size_t end;
+
+    part_range(job->w->boidCount, part, partCount, &begin, &end);
+    for (size_t i = begin; i < end; i++) {
+        const size_t k = cursor[(job->srcKeys[i] >> job->shift) & 0xFFu]++;
+        job->dstKeys[k] = job->srcKeys[i];
+        job->dstOrder[k] = job->srcOrder[i];
+    }
+}
+
+static void morton_gather_part(void* arg, size_t part, size_t partCount) {
+    MortonJob* job = (MortonJob*)arg;
+    World* w = job->w;
+    const BoidArrays* src = &w->boids;
+    BoidArrays* dst = &w->boidsNext;
+    size_t begin;
+    size_t end;
+
+    part_range(w->boidCount, part, partCount, &begin, &end);
+    for (size_t k = begin; k < end; k++) {
+        const size_t j = job->srcOrder[k];
+        dst->x[k] = src->x[j];
+        dst->y[k] = src->y[j];
+        dst->vx[k] = src->vx[j];
+        dst->vy[k] = src->vy[j];
+        dst->group[k] = src->group[j];
+        dst->flags[k] = src->flags[j];
+        w->sort.idTmp[k] = w->boidId[j];
+    }
+}
+
+bool world_reorder_morton(World* w, const WorldParallel* par) {
+    const size_t parts = world_parallel_parts(par);
+    MortonSort* ms = &w->sort;
+    MortonJob job;
+    int bits;
+    int passes;
+
+    if (w->boidCount < 2 || (uint64_t)w->boidCount > UINT32_MAX) return false;
+    if (!morton_sort_reserve(ms, w->boidCount, parts)) return false;
+
+    memset(&job, 0, sizeof(job));
+    job.w = w;
+    grid_dims(w, &job.cols, &job.rows);
+    if (job.cols > 0x8000) job.cols = 0x8000;
+    if (job.rows > 0x8000) job.rows = 0x8000;
+    job.cellW = (float)w->width / (float)job.cols;
+    job.cellH = (float)w->height / (float)job.rows;
+
+    /* alive keys use 2 * bits bits, the dead key sits one bit above them so dead boids sort last */
+    bits = bit_width((uint32_t)(job.cols > job.rows ? job.cols : job.rows) - 1u);
+    job.deadKey = (uint32_t)1u << (2 * bits);
+    passes = (2 * bits + 1 + 7) / 8;
+
+    world_parallel_run(par, morton_keys_part, &job);
+
+    job.srcKeys = ms->keys;
+    job.srcOrder = ms->order;
+    job.dstKeys = ms->keysTmp;
+    job.dstOrder = ms->orderTmp;
+    for (int pass = 0; pass < passes; pass++) {
+        size_t sum = 0;
+
+        job.shift = 8 * pass;
+        world_parallel_run(par, morton_count_part, &job);
+
+        /* digit-major, part-minor prefix keeps the sort stable for any part count */
+        for (size_t d = 0; d < 256; d++) {
+            for (size_t p = 0; p < parts; p++) {
+                size_t count = ms->histogram[p * 256 + d];
+                ms->histogram[p * 256 + d] = sum;
+                sum += count;
+            }
+        }
+
+        world_parallel_run(par, morton_scatter_part, &job);
+
+        {
+            const uint32_t* keys = job.dstKeys;
+            const uint32_t* order = job.dstOrder;
+            job.dstKeys = (uint32_t*)job.srcKeys;
+            job.dstOrder = (uint32_t*)job.srcOrder;
+            job.srcKeys = keys;
+            job.srcOrder = order;
+        }
+    }
+
+    world_parallel_run(par, morton_gather_part, &job);
+    world_swap_buffers(w);
+    world_update_population(w);
+    w->lists.valid = false;
+    w->stepCostValid = false;
+    {
+        size_t* ids = w->boidId;
+        w->boidId = ms->idTmp;
+        ms->idTmp = ids;
+    }
+    return true;
+}
+
+bool world_reorder_if_due(World* w, const WorldParallel* par) {
+    if (w->sortInterval <= 0) return false;
+    if (++w->ticksSinceSort < w->sortInterval) return false;
+    w->ticksSinceSort = 0;
+    return world_reorder_morton(w, par);
+}
+
+/* stepCost of a live boid: this much fixed work plus one unit per candidate pair */
+enum {
+    STEP_COST_FIXED = 8,
+};
+
+/*
+   Body of world_step_range. hasPredators / hasDead are compile-time constants in every
+   caller below, so each variant drops the branches and passes its game mode never needs.
+*/
+static BOIDS_FORCE_INLINE void world_step_kernel(const World* r, World* w, size_t begin, size_t end, double dt,
+                                                 WorldStepTally* tally, const bool hasPredators, const bool hasDead) {
 
     const float maxSpeed = 30.0f;
     const float maxForce = 25.0f;
@@ -174,43 +1034,75 @@ void world_step_range(const World* r, World* w, size_t begin, size_t end, double
     const float wSeparation = 1.45f;
     const float wAvoidPlayer = 1.50f;
 
-    const float neighborRadius2 = neighborRadius * neighborRadius;
-
     const float worldW = (float)r->width;
     const float worldH = (float)r->height;
     const float eps2 = 1e-8f;
 
     const float predMaxSpeed = 44.0f;
     const float predMaxForce = 50.0f;
-    const float predSepRadius = 4.0f;
-    const float predSepRadius2 = predSepRadius * predSepRadius;
+    const float predSepRadius2 = BOIDS_PRED_SEP_RADIUS * BOIDS_PRED_SEP_RADIUS;
     const float wPredChase = 2.00f;
     const float wPredSep = 1.10f;
-    const float predAvoidRadius = 12.0f;
-    const float predAvoidRadius2 = predAvoidRadius * predAvoidRadius;
     const float wAvoidPred = 2.20f;
 
+    const BoidGrid* g = &r->grid;
+    const BoidArrays* in = &r->boids;
+    const BoidArrays* packed = &g->packed;
+    BoidArrays* out = &w->boidsNext;
+    const PreySpanFn preySpan = prey_span_for(r->kernel);
+    const NeighborLists* lists = (r->lists.enabled && r->lists.valid) ? &r->lists : NULL;
+
+    const float killR2 = r->rules.killRadius * r->rules.killRadius;
+    const float hitR2 = r->rules.hitRadius * r->rules.hitRadius;
+    size_t kills = 0;
+    size_t hits = 0;
+    uint64_t pairs = 0;
+
     for (size_t i = begin; i < end; i++) {
-        Boid b = r->boids[i];
+        Boid b = boid_arrays_load(in, i);
 
-        if (!b.alive) {
-            w->boidsNext[i] = b;
+        if (hasDead && !b.alive) {
+            boid_arrays_store(out, i, &b);
+            w->stepCost[i] = 1;
             continue;
         }
 
-        if (b.predator) {
-            Vec2 sumSep = {0, 0};
-            for (size_t j = 0; j < r->boidCount; j++) {
-                if (i == j) continue;
-                if (!r->boids[j].alive) continue;
+        /* fixed per-boid work plus one unit per neighbor candidate */
+        size_t cost = STEP_COST_FIXED + (hasPredators ? r->predatorCount : 0);
+        const size_t cell = g->boidCell[i];
+        const size_t self = g->boidSlot[i];
+        int spanX[3];
+        int spanY[3];
+        const int nx = grid_axis_span((int)(cell % (size_t)g->cols), g->cols, spanX);
+        const int ny = grid_axis_span((int)(cell / (size_t)g->cols), g->rows, spanY);
 
-                float dx = torus_delta(r->boids[j].pos.x - b.pos.x, worldW);
-                float dy = torus_delta(r->boids[j].pos.y - b.pos.y, worldH);
-                float d2 = dx * dx + dy * dy;
-                if (d2 < predSepRadius2 && d2 > 1e-6f) {
-                    Vec2 diff = (Vec2){dx, dy};
-                    Vec2 away = v_mul(v_norm(diff), -1.0f);
-                    sumSep = v_add(sumSep, v_div(away, sqrtf(d2)));
+        if (hasPredators && b.predator) {
+            Vec2 sumSep = {0, 0};
+            for (size_t p = 0; p < r->predatorCount; p++) {
+                const size_t j = r->predators[p];
+                if (j == i || (hasDead && !(in->flags[j] & BOID_FLAG_ALIVE))) continue;
+                predator_separate(&sumSep, torus_delta(in->x[j] - b.pos.x, worldW),
+                                  torus_delta(in->y[j] - b.pos.y, worldH), predSepRadius2);
+            }
+            if (lists) {
+                cost += lists->start[i + 1] - lists->start[i];
+                for (size_t k = lists->start[i]; k < lists->start[i + 1]; k++) {
+                    const size_t j = lists->items[k];
+                    if (hasDead && !(in->flags[j] & BOID_FLAG_ALIVE)) continue;
+                    predator_separate(&sumSep, torus_delta(in->x[j] - b.pos.x, worldW),
+                                      torus_delta(in->y[j] - b.pos.y, worldH), predSepRadius2);
+                }
+            } else {
+                for (int cy = 0; cy < ny; cy++) {
+                    for (int cx = 0; cx < nx; cx++) {
+                        const size_t c = (size_t)spanY[cy] * (size_t)g->cols + (size_t)spanX[cx];
+                        cost += g->cellStart[c + 1] - g->cellStart[c];
+                        for (size_t k = g->cellStart[c]; k < g->cellStart[c + 1]; k++) {
+                            if (k == self) continue;
+                            predator_separate(&sumSep, torus_delta(packed->x[k] - b.pos.x, worldW),
+                                              torus_delta(packed->y[k] - b.pos.y, worldH), predSepRadius2);
+                        }
+                    }
                 }
             }
 
@@ -234,57 +1126,47 @@ void world_step_range(const World* r, World* w, size_t begin, size_t end, double
             b.vel = v_limit(b.vel, predMaxSpeed);
             b.pos = v_add(b.pos, v_mul(b.vel, (float)dt));
             b.pos = wrap_pos(r, b.pos);
-            w->boidsNext[i] = b;
+            if (hitR2 > 0.0f) {
+                float hx = torus_delta(b.pos.x - r->player.pos.x, worldW);
+                float hy = torus_delta(b.pos.y - r->player.pos.y, worldH);
+                if (hx * hx + hy * hy < hitR2) hits++;
+            }
+            boid_arrays_store(out, i, &b);
+            w->stepCost[i] = (uint32_t)cost;
+            pairs += cost - STEP_COST_FIXED;
             continue;
         }
 
-        const unsigned char groupI = b.group;
-
-        Vec2 sumPos = {0, 0};
-        Vec2 sumVel = {0, 0};
-        Vec2 sumSep = {0, 0};
+        PreySums sums = {{0, 0}, {0, 0}, {0, 0}, 0};
         Vec2 sumPred = {0, 0};
-        int neighbors = 0;
-
-        for (size_t j = 0; j < r->boidCount; j++) {
-            if (i == j) continue;
-            if (!r->boids[j].alive) continue;
-
-            float dx = torus_delta(r->boids[j].pos.x - b.pos.x, worldW);
-            float dy = torus_delta(r->boids[j].pos.y - b.pos.y, worldH);
-            float d2 = dx * dx + dy * dy;
-
-            /* separation against everyone */
-            if (d2 < desiredSeparation2 && d2 > 1e-6f) {
-                Vec2 diff = (Vec2){dx, dy};
-                Vec2 away = v_mul(v_norm(diff), -1.0f);
-                sumSep = v_add(sumSep, v_div(away, sqrtf(d2)));
-            }
-
-            /* avoid predators */
-            if (r->boids[j].predator) {
-                if (d2 < predAvoidRadius2 && d2 > 1e-6f) {
-                    Vec2 diff = (Vec2){dx, dy};
-                    Vec2 away = v_mul(v_norm(diff), -1.0f);
-                    sumPred = v_add(sumPred, v_div(away, sqrtf(d2)));
+        for (size_t p = 0; hasPredators && p < r->predatorCount; p++) {
+            const size_t j = r->predators[p];
+            if (hasDead && !(in->flags[j] & BOID_FLAG_ALIVE)) continue;
+            prey_avoid_predator(&sums, &sumPred, torus_delta(in->x[j] - b.pos.x, worldW),
+                                torus_delta(in->y[j] - b.pos.y, worldH));
+        }
+        if (lists) {
+            cost += lists->start[i + 1] - lists->start[i];
+            prey_list_scalar(in, lists->items + lists->start[i], lists->start[i + 1] - lists->start[i],
+                             b.pos, b.group, worldW, worldH, &sums, hasDead);
+        } else {
+            for (int cy = 0; cy < ny; cy++) {
+                for (int cx = 0; cx < nx; cx++) {
+                    const size_t c = (size_t)spanY[cy] * (size_t)g->cols + (size_t)spanX[cx];
+                    cost += g->cellStart[c + 1] - g->cellStart[c];
+                    preySpan(packed, g->cellStart[c], g->cellStart[c + 1], self, b.pos, b.group, worldW, worldH, &sums);
                 }
-                continue;
-            }
-
-            /* cohesion/alignment only within the same group */
-            if (r->boids[j].group != groupI) continue;
-            if (d2 < neighborRadius2) {
-                neighbors++;
-                Vec2 localPos = v_add(b.pos, (Vec2){dx, dy});
-                sumPos = v_add(sumPos, localPos);
-                sumVel = v_add(sumVel, r->boids[j].vel);
             }
         }
 
+        const Vec2 sumVel = sums.vel;
+        const Vec2 sumSep = sums.sep;
+        const int neighbors = sums.neighbors;
+
         Vec2 accel = {0, 0};
 
         if (neighbors > 0) {
-            Vec2 center = v_mul(sumPos, 1.0f / (float)neighbors);
+            Vec2 center = v_add(b.pos, v_mul(sums.offset, 1.0f / (float)neighbors));
             Vec2 avgVel = v_mul(sumVel, 1.0f / (float)neighbors);
 
             Vec2 coh = (Vec2){0, 0};
@@ -317,7 +1199,7 @@ void world_step_range(const World* r, World* w, size_t begin, size_t end, double
             }
         }
 
-        if (v_len2(sumPred) > eps2) {
+        if (hasPredators && v_len2(sumPred) > eps2) {
             Vec2 desiredP = v_mul(v_norm(sumPred), maxSpeed);
             Vec2 ap = steer_towards(desiredP, b.vel, maxForce);
             accel = v_add(accel, v_mul(ap, wAvoidPred));
@@ -341,12 +1223,108 @@ void world_step_range(const World* r, World* w, size_t begin, size_t end, double
         b.pos = v_add(b.pos, v_mul(b.vel, (float)dt));
         b.pos = wrap_pos(r, b.pos);
 
-        w->boidsNext[i] = b;
+        if (killR2 > 0.0f) {
+            float kx = torus_delta(b.pos.x - r->player.pos.x, worldW);
+            float ky = torus_delta(b.pos.y - r->player.pos.y, worldH);
+            if (kx * kx + ky * ky < killR2) {
+                b.alive = 0;
+                kills++;
+            }
+        }
+
+        boid_arrays_store(out, i, &b);
+        w->stepCost[i] = (uint32_t)cost;
+        pairs += cost - STEP_COST_FIXED;
+    }
+
+    if (tally) {
+        tally->kills += kills;
+        tally->hits += hits;
+        tally->pairs += pairs;
+    }
+}
+
+/* one specialization per {predators present, dead boids present}, indexed by World.stepVariant */
+#define WORLD_STEP_VARIANT(name, hasPredators, hasDead)                                       \
+    static void name(const World* r, World* w, size_t begin, size_t end, double dt,            \
+                     WorldStepTally* tally) {                                                   \
+        world_step_kernel(r, w, begin, end, dt, tally, hasPredators, hasDead);                  \
+    }
+
+WORLD_STEP_VARIANT(world_step_peaceful, false, false)
+WORLD_STEP_VARIANT(world_step_predators, true, false)
+WORLD_STEP_VARIANT(world_step_dead, false, true)
+WORLD_STEP_VARIANT(world_step_predators_dead, true, true)
+
+#undef WORLD_STEP_VARIANT
+
+void world_step_range(const World* r, World* w, size_t begin, size_t end, double dt, WorldStepTally* tally) {
+    switch (r->stepVariant) {
+    case 0: world_step_peaceful(r, w, begin, end, dt, tally); break;
+    case 1: world_step_predators(r, w, begin, end, dt, tally); break;
+    case 2: world_step_dead(r, w, begin, end, dt, tally); break;
+    default: world_step_predators_dead(r, w, begin, end, dt, tally); break;
     }
 }
 
 void world_swap_buffers(World* w) {
-    Boid* tmp = w->boids;
+    BoidArrays tmp = w->boids;
     w->boids = w->boidsNext;
     w->boidsNext = tmp;
+    /* every slot was stepped in this order; the re-sort clears this again after its own swap */
+    w->stepCostValid = true;
+}
+
+static uint64_t hash_add(uint64_t h, uint64_t v) {
+    return splitmix64_mix((h + 0x9E3779B97F4A7C15ull) ^ v);
+}
+
+static uint64_t hash_float(float v, float quantum) {
+    uint32_t bits;
+
+    if (quantum > 0.0f) return (uint64_t)llround((double)v / (double)quantum);
+    v += 0.0f; /* -0 and +0 hash the same */
+    memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+uint64_t world_state_hash(const World* w, float quantum) {
+    uint64_t h = hash_add(0, w->boidCount);
+
+    for (size_t i = 0; i < w->boidCount; i++) {
+        h = hash_add(h, w->boidId[i]);
+        h = hash_add(h, ((uint64_t)w->boids.flags[i] << 8) | w->boids.group[i]);
+        h = hash_add(h, hash_float(w->boids.x[i], quantum));
+        h = hash_add(h, hash_float(w->boids.y[i], quantum));
+        h = hash_add(h, hash_float(w->boids.vx[i], quantum));
+        h = hash_add(h, hash_float(w->boids.vy[i], quantum));
+    }
+    return h;
+}
+
+void world_cost_partition(const World* w, size_t partCount, size_t* bounds) {
+    const size_t n = w->boidCount;
+    uint64_t total = 0;
+
+    if (partCount == 0) return;
+    if (!w->stepCostValid) {
+        for (size_t p = 0; p < partCount; p++) bounds[p] = (n * p) / partCount;
+        bounds[partCount] = n;
+        return;
+    }
+
+    for (size_t i = 0; i < n; i++) total += w->stepCost[i];
+
+    /* part p starts at the first boid whose cost prefix reaches total * p / partCount */
+    {
+        uint64_t prefix = 0;
+        size_t p = 1;
+        bounds[0] = 0;
+        for (size_t i = 0; i < n && p < partCount; i++) {
+            while (p < partCount && prefix >= (total * p) / partCount) bounds[p++] = i;
+            prefix += w->stepCost[i];
+        }
+        while (p < partCount) bounds[p++] = n;
+        bounds[partCount] = n;
+    }
 }
@@ -2,12 +2,14 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 typedef struct Vec2 {
     float x;
     float y;
 } Vec2;
 
+/* AoS view of a single boid, used by rendering and the game rules */
 typedef struct Boid {
     Vec2 pos;
     Vec2 vel;
@@ -16,19 +18,146 @@ typedef struct Boid {
     unsigned char predator;
 } Boid;
 
+enum {
+    BOID_FLAG_ALIVE = 1u << 0,
+    BOID_FLAG_PREDATOR = 1u << 1,
+};
+
+/*
+   Structure-of-arrays boid storage. Every array starts on a 64-byte boundary inside
+   one allocation (block), so the neighbor loop only pulls in the fields it reads.
+*/
+typedef struct BoidArrays {
+    void* block;
+    float* x;
+    float* y;
+    float* vx;
+    float* vy;
+    unsigned char* group;
+    unsigned char* flags;
+} BoidArrays;
+
 typedef struct Player {
     Vec2 pos;
     float speed;
 } Player;
 
+/*
+   Uniform torus grid over the world, rebuilt every tick from World.boids.
+   cellBoids holds the alive prey indices ordered by cell, cellStart[c]..cellStart[c + 1]
+   is the slice of cell c. Predators are not stored (see World.predators) but still get
+   a boidCell. The cell edge is never smaller than the largest prey interaction radius,
+   so the 3x3 block around a boid covers every possible neighbor.
+*/
+typedef struct BoidGrid {
+    int cols;
+    int rows;
+    float cellW;
+    float cellH;
+    size_t cellCapacity;
+    size_t* cellStart;
+    size_t* cellBoids;
+    size_t* boidCell;
+    size_t* boidSlot;  /* position of each alive prey in cellBoids / packed, SIZE_MAX otherwise */
+    BoidArrays packed; /* copy of the alive boids in cellBoids order, contiguous per cell */
+} BoidGrid;
+
+/* implementation of the prey neighbor loop; AUTO resolves to the best one the CPU supports */
+typedef enum BoidKernel {
+    BOID_KERNEL_AUTO = 0,
+    BOID_KERNEL_SCALAR,
+    BOID_KERNEL_SSE2,
+    BOID_KERNEL_AVX2,
+} BoidKernel;
+
+/* scratch buffers of the Morton re-sort, allocated on first use */
+typedef struct MortonSort {
+    size_t capacity;
+    uint32_t* keys;
+    uint32_t* keysTmp;
+    uint32_t* order;
+    uint32_t* orderTmp;
+    size_t* idTmp;
+    size_t* histogram; /* 256 digit counters per part */
+    size_t histogramParts;
+} MortonSort;
+
+/*
+   Verlet neighbor lists in CSR form: the candidates of boid i are items[start[i]..start[i + 1]),
+   every boid that was within its interaction radius + skin at the last build. They are rebuilt
+   only when some boid has moved more than skin / 2 since then, which keeps them a superset of
+   the real neighbors. The buffers are reused across rebuilds and only grow.
+*/
+typedef struct NeighborLists {
+    bool enabled;
+    bool valid;
+    float skin;
+    size_t* start;
+    uint32_t* items;
+    size_t itemCapacity;
+    float* refX; /* positions at the last build */
+    float* refY;
+    size_t rebuilds;
+    size_t ticks;
+} NeighborLists;
+
+/*
+   Game rules checked by world_step_range right after each boid is integrated, while its slot
+   is still in cache. A radius of 0 turns the rule off.
+*/
+typedef struct WorldRules {
+    float killRadius; /* prey ending the tick this close to the player die */
+    float hitRadius;  /* predators ending the tick this close to the player hit it */
+} WorldRules;
+
+/* what the rules caught; world_step_range adds to it, slices are reduced by summing */
+typedef struct WorldStepTally {
+    size_t kills;
+    size_t hits;
+    uint64_t pairs; /* neighbor and predator candidates looked at */
+} WorldStepTally;
+
+typedef void (*WorldPartFn)(void* arg, size_t part, size_t partCount);
+
+/*
+   Fork-join hook for the world passes that can run in parallel: run calls
+   fn(arg, p, partCount) once for every p in [0, partCount) and returns when all are done.
+   A NULL WorldParallel means serial execution on the calling thread.
+*/
+typedef struct WorldParallel {
+    void (*run)(void* ctx, WorldPartFn fn, void* arg);
+    void* ctx;
+    size_t partCount;
+} WorldParallel;
+
+struct PhaseProfiler; /* profiler.h */
+
 typedef struct World {
     int width;
     int height;
     int groupCount;
     size_t boidCount;
-    Boid* boids;
-    Boid* boidsNext;
+    BoidArrays boids;
+    BoidArrays boidsNext;
     Player player;
+    bool useGrid; /* false: a single cell, the all-pairs scan (--neighbors allpairs) */
+    BoidGrid grid;
+    BoidKernel kernel;
+    size_t* boidId;   /* original index of the boid in each slot, permuted by the re-sort */
+    size_t* predators; /* dense index of the predator slots */
+    size_t predatorCount;
+    size_t deadCount;
+    int stepVariant; /* specialized world_step_range body, see world_update_population */
+    int sortInterval; /* Morton re-sort every N ticks, 0 = off */
+    int ticksSinceSort;
+    MortonSort sort;
+    NeighborLists lists;
+    uint32_t* stepCost; /* per slot work of the last world_step_range, see world_cost_partition */
+    bool stepCostValid;  /* false until a full step ran on the current slot order */
+    WorldRules rules;
+    WorldStepTally tally; /* rules caught by the last full step, summed over its slices */
+    uint64_t stepPairs;   /* tally.pairs of every full step so far, the updaters add it up */
+    struct PhaseProfiler* profiler; /* optional: the updaters time their tick phases into it */
 } World;
 
 typedef struct InputState {
@@ -38,11 +167,132 @@ typedef struct InputState {
     bool right;
 } InputState;
 
-bool world_init(World* world, int width, int height, size_t boidCount);
+static inline Boid boid_arrays_load(const BoidArrays* a, size_t i) {
+    Boid b;
+    b.pos = (Vec2){a->x[i], a->y[i]};
+    b.vel = (Vec2){a->vx[i], a->vy[i]};
+    b.group = a->group[i];
+    b.alive = (a->flags[i] & BOID_FLAG_ALIVE) ? 1 : 0;
+    b.predator = (a->flags[i] & BOID_FLAG_PREDATOR) ? 1 : 0;
+    return b;
+}
+
+static inline void boid_arrays_store(BoidArrays* a, size_t i, const Boid* b) {
+    a->x[i] = b->pos.x;
+    a->y[i] = b->pos.y;
+    a->vx[i] = b->vel.x;
+    a->vy[i] = b->vel.y;
+    a->group[i] = b->group;
+    a->flags[i] = (unsigned char)((b->alive ? BOID_FLAG_ALIVE : 0u) | (b->predator ? BOID_FLAG_PREDATOR : 0u));
+}
+
+/* accessor layer over the current buffer */
+static inline Boid world_get_boid(const World* world, size_t i) {
+    return boid_arrays_load(&world->boids, i);
+}
+
+static inline void world_set_boid(World* world, size_t i, const Boid* boid) {
+    boid_arrays_store(&world->boids, i, boid);
+}
+
+static inline bool world_boid_alive(const World* world, size_t i) {
+    return (world->boids.flags[i] & BOID_FLAG_ALIVE) != 0;
+}
+
+static inline bool world_boid_predator(const World* world, size_t i) {
+    return (world->boids.flags[i] & BOID_FLAG_PREDATOR) != 0;
+}
+
+/*
+   Counter-based PRNG (SplitMix64 finalizer over seed, stream and index): every value depends
+   only on its coordinates, so threads can draw any boid's numbers in any order.
+*/
+uint64_t boids_rng_u64(uint64_t seed, uint64_t stream, uint64_t index);
+float boids_rng_float01(uint64_t seed, uint64_t stream, uint64_t index); /* [0, 1) */
+
+/*
+   Creates the world for the given seed. The boids are filled through par (may be NULL);
+   the result is bit-identical for any part count.
+*/
+bool world_init(World* world, int width, int height, size_t boidCount, uint64_t seed, const WorldParallel* par);
 void world_destroy(World* world);
 
+BoidKernel boids_best_kernel(void);
+bool boids_kernel_supported(BoidKernel kernel);
+const char* boids_kernel_name(BoidKernel kernel);
+
+/*
+   Selects the grid neighbor loop used by world_step_range; the Verlet list walk is always scalar.
+   Returns false (and keeps the current one) if unsupported.
+*/
+bool world_set_kernel(World* world, BoidKernel kernel);
+
+/*
+   Rebuilds world->predators and deadCount from the flags and picks the world_step_range
+   variant specialized for {predators present, dead boids present}. Call after spawning
+   predators or killing boids.
+*/
+void world_update_population(World* world);
+
+/*
+   Stable in-place removal of the dead boids: the live ones keep their order (and boidId)
+   and move to [0, n), boidCount drops to n. Every loop over boidCount, the step kernel
+   included, then only sees live boids. Returns the number of boids removed.
+*/
+size_t world_compact_dead(World* world);
+
+/*
+   Resizes the torus and wraps the player into it. The Verlet lists and step costs were built
+   with the old wrap distances, so a changed size invalidates both.
+*/
+void world_set_size(World* world, int width, int height);
+
 void world_apply_player_input(World* world, const InputState* input, double dt);
 
-void world_step_range(const World* worldRead, World* worldWrite, size_t begin, size_t end, double dt);
+/* Velocity impulse away from the player for every live boid within radius. par may be NULL (serial). */
+void world_apply_shockwave(World* world, float radius, float strength, const WorldParallel* par);
+
+/*
+   Reorders the boids by the Morton code of their grid cell (dead boids last) with a
+   parallel LSD radix sort, so spatial neighbors get nearby indices. Group, flags and
+   boidId travel with each boid. Invalidates the grid: call before world_prepare_step.
+*/
+bool world_reorder_morton(World* world, const WorldParallel* par);
+
+/* Runs world_reorder_morton once every world->sortInterval calls. Returns true if it sorted. */
+bool world_reorder_if_due(World* world, const WorldParallel* par);
+
+/*
+   Switches world_step_range between the per-tick grid scan and Verlet neighbor lists built
+   with the given skin. Returns false if the list buffers cannot be allocated.
+*/
+bool world_set_neighbor_lists(World* world, bool enabled, float skin);
+
+/*
+   Rebuilds the neighbor grid from world->boids (with Verlet lists: only when they went stale,
+   then the lists too). Call once per tick before world_step_range. par may be NULL (serial).
+*/
+void world_prepare_step(World* world, const WorldParallel* par);
+
+/*
+   Steps [begin, end) from worldRead->boids into worldWrite->boidsNext and applies worldRead->rules
+   to the new positions (killed prey are stored dead). The catches are added to tally (may be NULL).
+*/
+void world_step_range(const World* worldRead, World* worldWrite, size_t begin, size_t end, double dt,
+                      WorldStepTally* tally);
 
 void world_swap_buffers(World* world);
+
+/*
+   Splits [0, boidCount) into partCount ranges of about equal cost as measured by the last
+   step (neighbor candidates per boid), bounds gets partCount + 1 entries. Without a valid
+   measurement (after init, re-sort or compaction) the ranges hold equal boid counts.
+*/
+void world_cost_partition(const World* world, size_t partCount, size_t* bounds);
+
+/*
+   64-bit hash of the boid state: count, slot order (boidId), flags, group, and positions and
+   velocities rounded to multiples of quantum (0 hashes the exact float bits). Worlds that
+   stepped the same way hash the same; values close to a rounding edge can still split.
+*/
+uint64_t world_state_hash(const World* world, float quantum);
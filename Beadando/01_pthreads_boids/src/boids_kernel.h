@@ -0,0 +1,48 @@
+#pragma once
+
+/*
+   Internal interface between the step kernel in boids.c and the explicitly
+   vectorized neighbor loops in boids_simd.c. Not part of the public world API.
+*/
+
+#include "boids.h"
+
+#if defined(__GNUC__)
+#define BOIDS_FORCE_INLINE inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define BOIDS_FORCE_INLINE __forceinline
+#else
+#define BOIDS_FORCE_INLINE inline
+#endif
+
+#define BOIDS_SEPARATION_RADIUS 2.2f
+#define BOIDS_NEIGHBOR_RADIUS 6.5f
+#define BOIDS_PRED_AVOID_RADIUS 12.0f
+#define BOIDS_PRED_SEP_RADIUS 4.0f
+#define BOIDS_MIN_DIST2 1e-6f
+
+/* elements of slack behind every packed array, so a full 8-wide load never leaves the allocation */
+#define BOIDS_SIMD_PAD 8
+
+/* per-boid accumulators of the prey neighbor loop (predators are handled through World.predators) */
+typedef struct PreySums {
+    Vec2 sep;
+    Vec2 offset; /* sum of torus offsets to same-group neighbors */
+    Vec2 vel;
+    int neighbors;
+} PreySums;
+
+/*
+   Accumulates the interaction of one boid with the packed prey candidates
+   [begin, end). self is the packed slot of the boid itself (skipped).
+*/
+typedef void (*PreySpanFn)(const BoidArrays* packed, size_t begin, size_t end, size_t self,
+                           Vec2 pos, unsigned char group, float worldW, float worldH, PreySums* sums);
+
+bool boids_cpu_has_sse2(void);
+bool boids_cpu_has_avx2(void);
+
+void prey_span_sse2(const BoidArrays* packed, size_t begin, size_t end, size_t self,
+                    Vec2 pos, unsigned char group, float worldW, float worldH, PreySums* sums);
+void prey_span_avx2(const BoidArrays* packed, size_t begin, size_t end, size_t self,
+                    Vec2 pos, unsigned char group, float worldW, float worldH, PreySums* sums);
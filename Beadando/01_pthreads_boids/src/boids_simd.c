@@ -0,0 +1,225 @@
+#include "boids_kernel.h"
+
+#include <string.h>
+
+/*
+   Vectorized prey neighbor loop. Each iteration handles 8 (AVX2) or 4 (SSE2) packed
+   candidates: the torus wrap is done with compare masks instead of branches and every
+   accumulator is masked, so the lanes past the span end or on the boid itself add zero.
+   Selected at runtime through CPUID (see world_set_kernel), the scalar loop in boids.c
+   stays the fallback and the reference.
+*/
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BOIDS_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#ifdef BOIDS_X86_SIMD
+
+bool boids_cpu_has_sse2(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2") != 0;
+}
+
+bool boids_cpu_has_avx2(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+}
+
+__attribute__((target("sse2")))
+static float hsum128(__m128 v) {
+    __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    sums = _mm_add_ss(sums, shuf);
+    return _mm_cvtss_f32(sums);
+}
+
+__attribute__((target("sse2")))
+static __m128i load4_u8(const unsigned char* p) {
+    int packed;
+    __m128i v;
+
+    memcpy(&packed, p, sizeof(packed));
+    v = _mm_cvtsi32_si128(packed);
+    v = _mm_unpacklo_epi8(v, _mm_setzero_si128());
+    return _mm_unpacklo_epi16(v, _mm_setzero_si128());
+}
+
+__attribute__((target("sse2")))
+static __m128 torus_delta_sse2(__m128 d, __m128 size, __m128 half) {
+    const __m128 over = _mm_cmpgt_ps(d, half);
+    const __m128 under = _mm_cmplt_ps(d, _mm_sub_ps(_mm_setzero_ps(), half));
+    d = _mm_sub_ps(d, _mm_and_ps(over, size));
+    return _mm_add_ps(d, _mm_and_ps(under, size));
+}
+
+__attribute__((target("sse2")))
+void prey_span_sse2(const BoidArrays* p, size_t begin, size_t end, size_t self,
+                    Vec2 pos, unsigned char group, float worldW, float worldH, PreySums* sums) {
+    const __m128 px = _mm_set1_ps(pos.x);
+    const __m128 py = _mm_set1_ps(pos.y);
+    const __m128 sizeX = _mm_set1_ps(worldW);
+    const __m128 sizeY = _mm_set1_ps(worldH);
+    const __m128 halfX = _mm_set1_ps(0.5f * worldW);
+    const __m128 halfY = _mm_set1_ps(0.5f * worldH);
+    const __m128 sep2 = _mm_set1_ps(BOIDS_SEPARATION_RADIUS * BOIDS_SEPARATION_RADIUS);
+    const __m128 neighbor2 = _mm_set1_ps(BOIDS_NEIGHBOR_RADIUS * BOIDS_NEIGHBOR_RADIUS);
+    const __m128 minDist2 = _mm_set1_ps(BOIDS_MIN_DIST2);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128i lane = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i groupI = _mm_set1_epi32(group);
+    const __m128i count = _mm_set1_epi32((int)(end - begin));
+    const __m128i selfRel = _mm_set1_epi32((self >= begin && self < end) ? (int)(self - begin) : -1);
+
+    __m128 sepX = _mm_setzero_ps();
+    __m128 sepY = _mm_setzero_ps();
+    __m128 offX = _mm_setzero_ps();
+    __m128 offY = _mm_setzero_ps();
+    __m128 velX = _mm_setzero_ps();
+    __m128 velY = _mm_setzero_ps();
+    __m128 neighbors = _mm_setzero_ps();
+
+    for (size_t k = begin; k < end; k += 4) {
+        const __m128i idx = _mm_add_epi32(_mm_set1_epi32((int)(k - begin)), lane);
+        const __m128 valid = _mm_castsi128_ps(_mm_andnot_si128(_mm_cmpeq_epi32(idx, selfRel), _mm_cmpgt_epi32(count, idx)));
+
+        const __m128 dx = torus_delta_sse2(_mm_sub_ps(_mm_loadu_ps(p->x + k), px), sizeX, halfX);
+        const __m128 dy = torus_delta_sse2(_mm_sub_ps(_mm_loadu_ps(p->y + k), py), sizeY, halfY);
+        const __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        const __m128 apart = _mm_and_ps(valid, _mm_cmpgt_ps(d2, minDist2));
+        const __m128 awayX = _mm_div_ps(_mm_sub_ps(_mm_setzero_ps(), dx), d2);
+        const __m128 awayY = _mm_div_ps(_mm_sub_ps(_mm_setzero_ps(), dy), d2);
+
+        const __m128i groups = load4_u8(p->group + k);
+        const __m128 sameGroup = _mm_castsi128_ps(_mm_cmpeq_epi32(groups, groupI));
+
+        const __m128 sepMask = _mm_and_ps(apart, _mm_cmplt_ps(d2, sep2));
+        const __m128 cohMask = _mm_and_ps(_mm_and_ps(valid, sameGroup), _mm_cmplt_ps(d2, neighbor2));
+
+        sepX = _mm_add_ps(sepX, _mm_and_ps(sepMask, awayX));
+        sepY = _mm_add_ps(sepY, _mm_and_ps(sepMask, awayY));
+        offX = _mm_add_ps(offX, _mm_and_ps(cohMask, dx));
+        offY = _mm_add_ps(offY, _mm_and_ps(cohMask, dy));
+        velX = _mm_add_ps(velX, _mm_and_ps(cohMask, _mm_loadu_ps(p->vx + k)));
+        velY = _mm_add_ps(velY, _mm_and_ps(cohMask, _mm_loadu_ps(p->vy + k)));
+        neighbors = _mm_add_ps(neighbors, _mm_and_ps(cohMask, one));
+    }
+
+    sums->sep.x += hsum128(sepX);
+    sums->sep.y += hsum128(sepY);
+    sums->offset.x += hsum128(offX);
+    sums->offset.y += hsum128(offY);
+    sums->vel.x += hsum128(velX);
+    sums->vel.y += hsum128(velY);
+    sums->neighbors += (int)hsum128(neighbors);
+}
+
+__attribute__((target("avx2")))
+static float hsum256(__m256 v) {
+    __m128 lo = _mm256_castps256_ps128(v);
+    __m128 hi = _mm256_extractf128_ps(v, 1);
+    __m128 sums = _mm_add_ps(lo, hi);
+    __m128 shuf = _mm_movehdup_ps(sums);
+    sums = _mm_add_ps(sums, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    sums = _mm_add_ss(sums, shuf);
+    return _mm_cvtss_f32(sums);
+}
+
+__attribute__((target("avx2")))
+static __m256i load8_u8(const unsigned char* p) {
+    return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)p));
+}
+
+__attribute__((target("avx2")))
+static __m256 torus_delta_avx2(__m256 d, __m256 size, __m256 half) {
+    const __m256 over = _mm256_cmp_ps(d, half, _CMP_GT_OQ);
+    const __m256 under = _mm256_cmp_ps(d, _mm256_sub_ps(_mm256_setzero_ps(), half), _CMP_LT_OQ);
+    d = _mm256_sub_ps(d, _mm256_and_ps(over, size));
+    return _mm256_add_ps(d, _mm256_and_ps(under, size));
+}
+
+__attribute__((target("avx2")))
+void prey_span_avx2(const BoidArrays* p, size_t begin, size_t end, size_t self,
+                    Vec2 pos, unsigned char group, float worldW, float worldH, PreySums* sums) {
+    const __m256 px = _mm256_set1_ps(pos.x);
+    const __m256 py = _mm256_set1_ps(pos.y);
+    const __m256 sizeX = _mm256_set1_ps(worldW);
+    const __m256 sizeY = _mm256_set1_ps(worldH);
+    const __m256 halfX = _mm256_set1_ps(0.5f * worldW);
+    const __m256 halfY = _mm256_set1_ps(0.5f * worldH);
+    const __m256 sep2 = _mm256_set1_ps(BOIDS_SEPARATION_RADIUS * BOIDS_SEPARATION_RADIUS);
+    const __m256 neighbor2 = _mm256_set1_ps(BOIDS_NEIGHBOR_RADIUS * BOIDS_NEIGHBOR_RADIUS);
+    const __m256 minDist2 = _mm256_set1_ps(BOIDS_MIN_DIST2);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i groupI = _mm256_set1_epi32(group);
+    const __m256i count = _mm256_set1_epi32((int)(end - begin));
+    const __m256i selfRel = _mm256_set1_epi32((self >= begin && self < end) ? (int)(self - begin) : -1);
+
+    __m256 sepX = _mm256_setzero_ps();
+    __m256 sepY = _mm256_setzero_ps();
+    __m256 offX = _mm256_setzero_ps();
+    __m256 offY = _mm256_setzero_ps();
+    __m256 velX = _mm256_setzero_ps();
+    __m256 velY = _mm256_setzero_ps();
+    __m256 neighbors = _mm256_setzero_ps();
+
+    for (size_t k = begin; k < end; k += 8) {
+        const __m256i idx = _mm256_add_epi32(_mm256_set1_epi32((int)(k - begin)), lane);
+        const __m256 valid = _mm256_castsi256_ps(_mm256_andnot_si256(_mm256_cmpeq_epi32(idx, selfRel), _mm256_cmpgt_epi32(count, idx)));
+
+        const __m256 dx = torus_delta_avx2(_mm256_sub_ps(_mm256_loadu_ps(p->x + k), px), sizeX, halfX);
+        const __m256 dy = torus_delta_avx2(_mm256_sub_ps(_mm256_loadu_ps(p->y + k), py), sizeY, halfY);
+        const __m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        const __m256 apart = _mm256_and_ps(valid, _mm256_cmp_ps(d2, minDist2, _CMP_GT_OQ));
+        const __m256 awayX = _mm256_div_ps(_mm256_sub_ps(_mm256_setzero_ps(), dx), d2);
+        const __m256 awayY = _mm256_div_ps(_mm256_sub_ps(_mm256_setzero_ps(), dy), d2);
+
+        const __m256i groups = load8_u8(p->group + k);
+        const __m256 sameGroup = _mm256_castsi256_ps(_mm256_cmpeq_epi32(groups, groupI));
+
+        const __m256 sepMask = _mm256_and_ps(apart, _mm256_cmp_ps(d2, sep2, _CMP_LT_OQ));
+        const __m256 cohMask = _mm256_and_ps(_mm256_and_ps(valid, sameGroup), _mm256_cmp_ps(d2, neighbor2, _CMP_LT_OQ));
+
+        sepX = _mm256_add_ps(sepX, _mm256_and_ps(sepMask, awayX));
+        sepY = _mm256_add_ps(sepY, _mm256_and_ps(sepMask, awayY));
+        offX = _mm256_add_ps(offX, _mm256_and_ps(cohMask, dx));
+        offY = _mm256_add_ps(offY, _mm256_and_ps(cohMask, dy));
+        velX = _mm256_add_ps(velX, _mm256_and_ps(cohMask, _mm256_loadu_ps(p->vx + k)));
+        velY = _mm256_add_ps(velY, _mm256_and_ps(cohMask, _mm256_loadu_ps(p->vy + k)));
+        neighbors = _mm256_add_ps(neighbors, _mm256_and_ps(cohMask, one));
+    }
+
+    sums->sep.x += hsum256(sepX);
+    sums->sep.y += hsum256(sepY);
+    sums->offset.x += hsum256(offX);
+    sums->offset.y += hsum256(offY);
+    sums->vel.x += hsum256(velX);
+    sums->vel.y += hsum256(velY);
+    sums->neighbors += (int)hsum256(neighbors);
+}
+
+#else
+
+bool boids_cpu_has_sse2(void) {
+    return false;
+}
+
+bool boids_cpu_has_avx2(void) {
+    return false;
+}
+
+void prey_span_sse2(const BoidArrays* p, size_t begin, size_t end, size_t self,
+                    Vec2 pos, unsigned char group, float worldW, float worldH, PreySums* sums) {
+    (void)p; (void)begin; (void)end; (void)self; (void)pos; (void)group; (void)worldW; (void)worldH; (void)sums;
+}
+
+void prey_span_avx2(const BoidArrays* p, size_t begin, size_t end, size_t self,
+                    Vec2 pos, unsigned char group, float worldW, float worldH, PreySums* sums) {
+    (void)p; (void)begin; (void)end; (void)self; (void)pos; (void)group; (void)worldW; (void)worldH; (void)sums;
+}
+
+#endif
@@ -0,0 +1,234 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include "cpu_affinity.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+size_t cpu_online_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors > 0 ? (size_t)si.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (size_t)n : 1;
+#endif
+}
+
+const char* cpu_pin_mode_name(CpuPinMode mode) {
+    switch (mode) {
+        case CPU_PIN_NONE: return "none";
+        case CPU_PIN_COMPACT: return "compact";
+        case CPU_PIN_SCATTER: return "scatter";
+        case CPU_PIN_LIST: return "list";
+    }
+    return "unknown";
+}
+
+/* physical package (socket) of a cpu, -1 if the topology is not exposed */
+static int cpu_package(int cpu) {
+#ifdef __linux__
+    char path[96];
+    FILE* f;
+    int id = -1;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+    f = fopen(path, "r");
+    if (!f) return -1;
+    if (fscanf(f, "%d", &id) != 1) id = -1;
+    fclose(f);
+    return id;
+#else
+    (void)cpu;
+    return -1;
+#endif
+}
+
+/*
+   Cpus the process may run on, ascending: the sched_getaffinity mask on Linux (taskset, cgroup
+   cpusets), the process affinity mask on Windows, every online cpu elsewhere. Returns the count,
+   0 without memory; *out is freed by the caller.
+*/
+static size_t usable_cpus(int** out) {
+    size_t n = 0;
+#if defined(__linux__)
+    cpu_set_t set;
+    int* cpus = (int*)malloc(CPU_SETSIZE * sizeof(int));
+
+    if (!cpus) return 0;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; c++) {
+            if (CPU_ISSET(c, &set)) cpus[n++] = c;
+        }
+    }
+#elif defined(_WIN32)
+    DWORD_PTR processMask;
+    DWORD_PTR systemMask;
+    const int bitCount = (int)(8 * sizeof(DWORD_PTR));
+    int* cpus = (int*)malloc((size_t)bitCount * sizeof(int));
+
+    if (!cpus) return 0;
+    if (GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask)) {
+        for (int c = 0; c < bitCount; c++) {
+            if (processMask & ((DWORD_PTR)1 << c)) cpus[n++] = c;
+        }
+    }
+#else
+    const size_t online = cpu_online_count();
+    int* cpus = (int*)malloc(online * sizeof(int));
+
+    if (!cpus) return 0;
+#endif
+    if (n == 0) {
+        /* mask unreadable: fall back to the online cpus */
+        const size_t online = cpu_online_count();
+        int* all = (int*)realloc(cpus, online * sizeof(int));
+        if (!all) {
+            free(cpus);
+            return 0;
+        }
+        cpus = all;
+        for (size_t c = 0; c < online; c++) cpus[c] = (int)c;
+        n = online;
+    }
+    *out = cpus;
+    return n;
+}
+
+/*
+   cpus[0..cpuCount) reordered package-interleaved: first cpu of every package, then the second
+   one, ... Without topology information the order stays as it is.
+*/
+static void scatter_order(const int* cpus, int* order, size_t cpuCount) {
+    int* package = (int*)malloc(cpuCount * sizeof(int));
+    unsigned char* used = (unsigned char*)calloc(cpuCount, 1);
+    int packageCount = 0;
+    bool known = package && used;
+
+    for (size_t c = 0; known && c < cpuCount; c++) {
+        package[c] = cpu_package(cpus[c]);
+        if (package[c] < 0) known = false;
+        else if (package[c] + 1 > packageCount) packageCount = package[c] + 1;
+    }
+
+    if (known) {
+        size_t n = 0;
+        while (n < cpuCount) {
+            for (int p = 0; p < packageCount; p++) {
+                for (size_t c = 0; c < cpuCount; c++) {
+                    if (used[c] || package[c] != p) continue;
+                    used[c] = 1;
+                    order[n++] = cpus[c];
+                    break;
+                }
+            }
+        }
+    } else {
+        for (size_t c = 0; c < cpuCount; c++) order[c] = cpus[c];
+    }
+
+    free(package);
+    free(used);
+}
+
+/* compact and scatter only hand out cpus of the process affinity mask */
+bool cpu_pin_plan(CpuPinMode mode, const int* list, size_t listCount, size_t partCount, int* outCpus) {
+    int* cpus = NULL;
+    size_t cpuCount;
+
+    switch (mode) {
+        case CPU_PIN_NONE:
+            return false;
+        case CPU_PIN_COMPACT:
+            cpuCount = usable_cpus(&cpus);
+            if (cpuCount == 0) return false;
+            for (size_t p = 0; p < partCount; p++) outCpus[p] = cpus[p % cpuCount];
+            free(cpus);
+            return true;
+        case CPU_PIN_SCATTER: {
+            int* order;
+            cpuCount = usable_cpus(&cpus);
+            if (cpuCount == 0) return false;
+            order = (int*)malloc(cpuCount * sizeof(int));
+            if (!order) {
+                free(cpus);
+                return false;
+            }
+            scatter_order(cpus, order, cpuCount);
+            for (size_t p = 0; p < partCount; p++) outCpus[p] = order[p % cpuCount];
+            free(order);
+            free(cpus);
+            return true;
+        }
+        case CPU_PIN_LIST:
+            if (!list || listCount == 0) return false;
+            for (size_t p = 0; p < partCount; p++) outCpus[p] = list[p % listCount];
+            return true;
+    }
+    return false;
+}
+
+bool cpu_pin_current_thread(int cpu) {
+    if (cpu < 0) return false;
+#if defined(_WIN32)
+    if (cpu >= (int)(8 * sizeof(DWORD_PTR))) return false;
+    return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    if (cpu >= CPU_SETSIZE) return false;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+bool cpu_affinity_save(CpuAffinity* out) {
+    memset(out, 0, sizeof(*out));
+#if defined(_WIN32)
+    DWORD_PTR processMask;
+    DWORD_PTR systemMask;
+    DWORD_PTR old;
+    /* Windows only reports a thread mask when setting a new one */
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask)) return false;
+    old = SetThreadAffinityMask(GetCurrentThread(), processMask);
+    if (old == 0) return false;
+    SetThreadAffinityMask(GetCurrentThread(), old);
+    out->bits[0] = (uint64_t)old;
+    return true;
+#elif defined(__linux__)
+    cpu_set_t set;
+    _Static_assert(sizeof(cpu_set_t) <= sizeof(out->bits), "CpuAffinity too small for cpu_set_t");
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) != 0) return false;
+    memcpy(out->bits, &set, sizeof(set));
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool cpu_affinity_restore(const CpuAffinity* a) {
+#if defined(_WIN32)
+    return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)a->bits[0]) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    memcpy(&set, a->bits, sizeof(set));
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)a;
+    return false;
+#endif
+}
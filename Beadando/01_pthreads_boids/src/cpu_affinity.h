@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum CpuPinMode {
+    CPU_PIN_NONE = 0, /* the OS places the threads */
+    CPU_PIN_COMPACT,  /* part p on the p-th allowed cpu, neighboring parts share caches */
+    CPU_PIN_SCATTER,  /* parts spread over the packages (sockets) first, then over their cpus */
+    CPU_PIN_LIST,     /* part p on list[p % listCount] */
+} CpuPinMode;
+
+enum {
+    CPU_PIN_LIST_MAX = 256,
+};
+
+/* affinity of a thread, saved before cpu_pin_current_thread to undo it later */
+typedef struct CpuAffinity {
+    uint64_t bits[16]; /* cpu_set_t on Linux, the DWORD_PTR mask on Windows */
+} CpuAffinity;
+
+size_t cpu_online_count(void);
+const char* cpu_pin_mode_name(CpuPinMode mode);
+
+/*
+   Fills outCpus[0..partCount) for the mode; compact and scatter pick from the cpus the process
+   affinity mask allows. Returns false for CPU_PIN_NONE or an empty list.
+*/
+bool cpu_pin_plan(CpuPinMode mode, const int* list, size_t listCount, size_t partCount, int* outCpus);
+
+/* Binds the calling thread to one cpu. Returns false where the platform does not support it. */
+bool cpu_pin_current_thread(int cpu);
+
+/* The calling thread's affinity; restore puts it back. Both false where it is not supported. */
+bool cpu_affinity_save(CpuAffinity* out);
+bool cpu_affinity_restore(const CpuAffinity* a);
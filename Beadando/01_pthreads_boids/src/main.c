@@ -1,7 +1,23 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include "bench_core.h"
+#include "bench_stats.h"
 #include "boids.h"
+#include "cpu_affinity.h"
+#include "perf_counters.h"
+#include "profiler.h"
+#include "sim_snapshot.h"
+#include "spin_barrier.h"
+#include "trace.h"
 #include "update_pthreads.h"
+#include "updater.h"
 
+#include <errno.h>
 #include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdarg.h>
@@ -137,47 +153,53 @@ void SDL_RenderPresent(SDL_Renderer* renderer);
 #include <windows.h>
 #endif
 
-typedef enum RunMode {
-    RUNMODE_SEQ = 0,
-    RUNMODE_PTHREAD = 1,
-} RunMode;
-
 typedef enum GameMode {
     GAMEMODE_PEACEFUL = 0,
     GAMEMODE_SURVIVAL = 1,
     GAMEMODE_TERMINATE44 = 2,
 } GameMode;
 
+/* lo, lo * factor, lo * factor^2, ... up to hi */
+typedef struct SweepRange {
+    int lo;
+    int hi;
+    int factor;
+} SweepRange;
+
 typedef struct AppConfig {
-    int width;
-    int height;
-    int boidCount;
-    int threadCount;
-    RunMode mode;
+    BenchOptions run; /* world, updater and benchmark options, shared with the headless driver */
     GameMode gameMode;
     bool benchmarkMode;
     bool benchmarkCompare;
     bool liveBenchmarkSession;
-    int benchmarkSteps;
-    int benchmarkWarmup;
+    bool kernelCheck;
+    bool gridCheck;
+    bool verify;           /* seq and --mode stepped in lockstep, first divergence reported */
+    float verifyTolerance; /* allowed position/velocity difference, also the hash quantum */
+    bool mortonCompare;
+    bool verletCompare;
+    bool syncBench;
+    bool scheduleCompare;
+    bool callerCompare;
+    bool batchCompare;
+    bool sweep;
+    SweepRange sweepThreads;
+    SweepRange sweepBoids;
+    const char* tracePath; /* Chrome trace_event JSON, needs a BOIDS_TRACE build */
 } AppConfig;
 
-typedef struct BenchmarkResult {
-    double totalMs;
-    double avgMs;
-    double ticksPerSecond;
-} BenchmarkResult;
-
 enum {
-    BENCHMARK_WARMUP_STEPS = 100,
+    TRACE_SPANS_PER_THREAD = 1 << 18,
 };
 
 typedef struct LiveBenchmarkState {
     bool enabled;
     uint64_t startUs;
     uint64_t lastLogUs;
-    double intervalMsSum;
-    int intervalTickCount;
+    uint64_t lastTick;      /* sim counters of the last log, from the snapshot */
+    double lastTickMsSum;
+    int intervalFrames;
+    PhaseTotals lastPhases; /* profiler totals at the last log */
 } LiveBenchmarkState;
 
 typedef struct DropdownLayout {
@@ -249,8 +271,29 @@ typedef struct UiAssets {
 } UiAssets;
 
 static void print_usage(const char* exe) {
-    printf("Usage: %s [--mode seq|pthread] [--threads N] [--boids N] [--width W] [--height H] [--game peaceful|survival|terminate44]\n", exe);
-    printf("       %s --benchmark N [--compare] [--mode seq|pthread] [--threads N] [--boids N] [--width W] [--height H] [--game peaceful|survival|terminate44]\n", exe);
+    printf("Usage: %s [--mode seq|pthread|openmp] [--threads N] [--boids N] [--width W] [--height H] [--game peaceful|survival|terminate44]\n", exe);
+    printf("       %s --benchmark N [--compare] [--mode seq|pthread|openmp] [--threads N] [--boids N] [--width W] [--height H] [--game peaceful|survival|terminate44]\n", exe);
+    printf("       %s --benchmark N [--trials K] [--reject-outliers] [--bench-out FILE] [--mode seq|pthread|openmp] [--threads N] [--boids N]\n", exe);
+    printf("       %s --benchmark N --sweep [threads=LO..HI[*F]] [boids=LO..HI[*F]] [--mode pthread|openmp] [--bench-out FILE]\n", exe);
+    printf("       %s --benchmark N --kernel-check [--kernel sse2|avx2] [--boids N] [--width W] [--height H] [--game peaceful|survival|terminate44]\n", exe);
+    printf("       %s --benchmark N --grid-check [--neighbors grid|verlet] [--kernel K] [--boids N] [--width W] [--height H] [--game peaceful|survival|terminate44]\n", exe);
+    printf("       %s --benchmark N --verify [--verify-tol T] [--mode pthread|openmp] [--threads N] [--boids N] [--width W] [--height H]\n", exe);
+    printf("       %s --benchmark N --morton-compare [--morton K] [--mode seq|pthread|openmp] [--threads N] [--boids N] [--width W] [--height H]\n", exe);
+    printf("       %s --benchmark N --verlet-compare [--mode seq|pthread|openmp] [--threads N] [--boids N] [--width W] [--height H]\n", exe);
+    printf("       %s --benchmark N --sync-bench [--threads N] [--spin S]\n", exe);
+    printf("       %s --benchmark N --caller-compare [--boids N] [--width W] [--height H] [--game peaceful|survival|terminate44]\n", exe);
+    printf("       %s --benchmark N --batch-compare [--threads N] [--boids N] [--width W] [--height H] [--game peaceful|survival|terminate44]\n", exe);
+    printf("       %s --benchmark N --schedule-compare [--chunk N] [--threads N] [--boids N] [--width W] [--height H] [--game peaceful|survival|terminate44]\n", exe);
+    bench_print_options_usage();
+    printf("         --compare runs every built-in backend (seq, pthread, openmp) on the same world and prints a speedup table\n");
+    printf("         --sweep measures strong and weak scaling; threads step by *2 and boids by *10 unless F is given,\n");
+    printf("           k/M suffixes are allowed (boids=1k..1M), the world grows to keep the --boids/--width/--height density\n");
+    printf("         --profile in the game also times the draw steps; it is always on in the live benchmark log\n");
+    printf("         --trace FILE writes per-thread spans (worker parts, world_step_range, barriers, tick phases) as\n");
+    printf("           Chrome trace_event JSON; only in builds with make TRACE_FLAGS=-DBOIDS_TRACE\n");
+    printf("         --verify steps a seq and a --mode world in lockstep and reports the first tick and boid that differ by\n");
+    printf("           more than T (default: 1e-4, 0 = bit exact), comparing quantized state hashes every tick\n");
+    printf("         without --seed the game picks a time based seed\n");
     printf("Controls (in window): WASD move player, Q or ESC quit\n");
 }
 
@@ -271,12 +314,46 @@ static bool parse_game_mode(const char* s, GameMode* outMode) {
     return false;
 }
 
-static int parse_int(const char* s, int defaultValue) {
-    if (s == NULL) return defaultValue;
+/* count with an optional k (1000) or M (1000000) suffix */
+static bool parse_count(const char* s, char** end, int* out) {
+    long v = strtol(s, end, 10);
+
+    if (*end == s || v <= 0) return false;
+    if (**end == 'k' || **end == 'K') {
+        v *= 1000L;
+        (*end)++;
+    } else if (**end == 'M' || **end == 'm') {
+        v *= 1000000L;
+        (*end)++;
+    }
+    if (v > 100000000L) return false;
+    *out = (int)v;
+    return true;
+}
+
+/* LO[..HI][*FACTOR], e.g. 1..32 or 1k..1M*10 */
+static bool parse_sweep_range(const char* s, SweepRange* out) {
     char* end = NULL;
-    long v = strtol(s, &end, 10);
-    if (end == s) return defaultValue;
-    return (int)v;
+    SweepRange r = *out;
+
+    if (!parse_count(s, &end, &r.lo)) return false;
+    r.hi = r.lo;
+    if (strncmp(end, "..", 2) == 0 && !parse_count(end + 2, &end, &r.hi)) return false;
+    if (*end == '*') {
+        long f = strtol(end + 1, &end, 10);
+        if (f < 2) return false;
+        r.factor = (int)f;
+    }
+    if (*end != '\0' || r.hi < r.lo) return false;
+    *out = r;
+    return true;
+}
+
+/* the threads=... / boids=... words after --sweep */
+static bool parse_sweep_arg(const char* s, AppConfig* cfg) {
+    if (strncmp(s, "threads=", 8) == 0) return parse_sweep_range(s + 8, &cfg->sweepThreads);
+    if (strncmp(s, "boids=", 6) == 0) return parse_sweep_range(s + 6, &cfg->sweepBoids);
+    return false;
 }
 
 static uint64_t time_now_us(void) {
@@ -293,20 +370,42 @@ static void time_sleep_us(uint64_t us) {
     SDL_Delay(ms);
 }
 
+/*
+   Live game threading: the sim thread runs the fixed-timestep simulation and publishes a
+   snapshot after every batch of ticks, the main thread handles SDL, draws the latest snapshot
+   and sends input back through the command queue. Each side only touches its own AppState fields.
+*/
+typedef struct SimLink {
+    pthread_t thread;
+    atomic_bool stop;
+    SnapshotTriple snapshots;
+    SimCommandQueue commands;
+} SimLink;
+
 typedef struct AppState {
     AppConfig cfg;
     World world;
-    UpdatePthreads updater;
+    Updater updater; /* backend of cfg.run.mode, seq included */
     bool updaterInited;
+    PhaseProfiler* profiler; /* NULL unless profiling, see app_enable_profiler */
+    uint64_t worldSeed;  /* seed of the current world, derived from cfg.run.seed per reset */
+    unsigned resetCount;
 
     int baseWorldW;
     int baseWorldH;
     float targetPixelsPerUnit;
 
-    InputState input;
+    InputState input; /* sim thread copy of keys */
+    InputState keys;  /* render thread: movement keys held */
     Vec2 playerDir;
     bool shockRequest;
     bool quit;
+    SimLink* sim;     /* live game only: NULL in the benchmarks */
+    double simDt;
+    int viewW;        /* window size as last sent to the sim thread */
+    int viewH;
+    uint64_t simTicks;
+    double simMsSum;
 
     double avgMs;
     int avgCount;
@@ -318,6 +417,11 @@ typedef struct AppState {
     int winW;
     int winH;
     int titleCounter;
+    uint64_t rateStartUs;
+    int rateFrames;
+    uint64_t rateTick;
+    double renderFps;
+    double simTicksPerSec;
 
     GameMode gameMode;
     bool menuOpen;
@@ -338,18 +442,7 @@ static FILE* g_benchmarkLogFile = NULL;
 static char g_benchmarkLogPath[260] = {0};
 
 static void set_group_color(SDL_Renderer* r, unsigned char group, int groupCount);
-
-static float torus_delta_f(float d, float size) {
-    if (size <= 0.0f) return d;
-    float h = 0.5f * size;
-    if (d > h) d -= size;
-    else if (d < -h) d += size;
-    return d;
-}
-
-static const char* run_mode_name(RunMode mode) {
-    return mode == RUNMODE_SEQ ? "seq" : "pthread";
-}
+static void app_step_simulation(AppState* s, double simDt);
 
 static bool exe_name_is_benchmark(const char* exePath) {
     const char* base = exePath;
@@ -382,11 +475,13 @@ static bool benchmark_open_log_file(void) {
 #endif
 
     g_benchmarkLogFile = fopen(g_benchmarkLogPath, "w");
+    bench_set_log_file(g_benchmarkLogFile);
     return g_benchmarkLogFile != NULL;
 }
 
 static void benchmark_close_log_file(void) {
     if (!g_benchmarkLogFile) return;
+    bench_set_log_file(NULL);
     fclose(g_benchmarkLogFile);
     g_benchmarkLogFile = NULL;
 }
@@ -395,31 +490,6 @@ static const char* benchmark_log_path(void) {
     return g_benchmarkLogPath[0] ? g_benchmarkLogPath : NULL;
 }
 
-static void benchmark_write_text(const AppConfig* cfg, const char* text) {
-    (void)cfg;
-
-    if (!cfg || !text) return;
-
-    fputs(text, stdout);
-    fflush(stdout);
-
-    if (g_benchmarkLogFile) {
-        fputs(text, g_benchmarkLogFile);
-        fflush(g_benchmarkLogFile);
-    }
-}
-
-static void benchmark_printf(const AppConfig* cfg, const char* fmt, ...) {
-    char text[768];
-    va_list ap;
-
-    va_start(ap, fmt);
-    vsnprintf(text, sizeof(text), fmt, ap);
-    va_end(ap);
-
-    benchmark_write_text(cfg, text);
-}
-
 static void benchmark_attach_console(void) {
 #ifdef _WIN32
     static bool attached = false;
@@ -491,26 +561,26 @@ static int startup_read_edit_int(HWND edit, int fallbackValue) {
 static bool startup_collect_values(HWND hwnd, StartupPromptState* state) {
     AppConfig next = *state->cfg;
 
-    next.boidCount = startup_read_edit_int(state->boidsEdit, next.boidCount);
-    next.threadCount = startup_read_edit_int(state->threadsEdit, next.threadCount);
-    next.mode = next.threadCount <= 1 ? RUNMODE_SEQ : RUNMODE_PTHREAD;
+    next.run.boidCount = startup_read_edit_int(state->boidsEdit, next.run.boidCount);
+    next.run.threadCount = startup_read_edit_int(state->threadsEdit, next.run.threadCount);
+    next.run.mode = next.run.threadCount <= 1 ? UPDATER_SEQ : UPDATER_PTHREAD;
     next.benchmarkMode = false;
     next.benchmarkCompare = false;
     next.liveBenchmarkSession = false;
 
     if (state->benchmarkPrompt) {
-        next.benchmarkSteps = startup_read_edit_int(state->stepsEdit, next.benchmarkSteps);
-        next.benchmarkWarmup = BENCHMARK_WARMUP_STEPS;
+        next.run.benchmarkSteps = startup_read_edit_int(state->stepsEdit, next.run.benchmarkSteps);
+        next.run.benchmarkWarmup = BENCH_WARMUP_STEPS;
         next.benchmarkCompare = true;
         next.liveBenchmarkSession = true;
-        next.mode = next.threadCount <= 1 ? RUNMODE_SEQ : RUNMODE_PTHREAD;
+        next.run.mode = next.run.threadCount <= 1 ? UPDATER_SEQ : UPDATER_PTHREAD;
     }
 
-    if (next.boidCount <= 0 || next.threadCount <= 0) {
+    if (next.run.boidCount <= 0 || next.run.threadCount <= 0) {
         MessageBoxW(hwnd, L"A boidok és a szálak száma legyen pozitív.", L"Hibás adat", MB_ICONERROR | MB_OK);
         return false;
     }
-    if (state->benchmarkPrompt && next.benchmarkSteps <= 0) {
+    if (state->benchmarkPrompt && next.run.benchmarkSteps <= 0) {
         MessageBoxW(hwnd, L"Az összevetési lépések száma legyen pozitív.", L"Hibás adat", MB_ICONERROR | MB_OK);
         return false;
     }
@@ -541,19 +611,19 @@ static LRESULT CALLBACK startup_prompt_proc(HWND hwnd, UINT msg, WPARAM wParam,
         y += 32;
 
         startup_create_label(hwnd, L"Boid darab:", 18, y + 3, 120, 20);
-        swprintf(buffer, sizeof(buffer) / sizeof(buffer[0]), L"%d", state->cfg->boidCount);
+        swprintf(buffer, sizeof(buffer) / sizeof(buffer[0]), L"%d", state->cfg->run.boidCount);
         state->boidsEdit = startup_create_edit(hwnd, STARTUP_ID_BOIDS, buffer, 150, y, 140, 24);
         y += 34;
 
         startup_create_label(hwnd, L"Szálak száma:", 18, y + 3, 120, 20);
-        swprintf(buffer, sizeof(buffer) / sizeof(buffer[0]), L"%d", state->cfg->threadCount);
+        swprintf(buffer, sizeof(buffer) / sizeof(buffer[0]), L"%d", state->cfg->run.threadCount);
         state->threadsEdit = startup_create_edit(hwnd, STARTUP_ID_THREADS, buffer, 150, y, 140, 24);
         y += 34;
 
         if (state->benchmarkPrompt) {
             startup_create_label(hwnd, L"Összevetési lépések:", 18, y + 3, 120, 20);
             swprintf(buffer, sizeof(buffer) / sizeof(buffer[0]), L"%d",
-                     state->cfg->benchmarkSteps > 0 ? state->cfg->benchmarkSteps : 500);
+                     state->cfg->run.benchmarkSteps > 0 ? state->cfg->run.benchmarkSteps : 500);
             state->stepsEdit = startup_create_edit(hwnd, STARTUP_ID_STEPS, buffer, 150, y, 140, 24);
             y += 34;
         }
@@ -882,27 +952,27 @@ static void draw_mode_dropdown_fallback(SDL_Renderer* r, GameMode current, bool
     }
 }
 
-static void draw_mode_dropdown(AppState* s) {
-    draw_mode_dropdown_fallback(s->renderer, s->gameMode, s->menuOpen);
+static void draw_mode_dropdown(AppState* s, const SimSnapshot* snap) {
+    draw_mode_dropdown_fallback(s->renderer, (GameMode)snap->hud.gameMode, s->menuOpen);
 }
 
 static double survival_score_from_time(double survivalTime) {
     return survivalTime / 10.0;
 }
 
-static float shock_cooldown_ratio(const AppState* s) {
+static float shock_cooldown_ratio(const SimHud* hud) {
     const float maxCooldown = 1.0f;
-    float value = (float)(s->shockCooldown / (double)maxCooldown);
+    float value = (float)(hud->shockCooldown / (double)maxCooldown);
     if (value < 0.0f) value = 0.0f;
     if (value > 1.0f) value = 1.0f;
     return value;
 }
 
-static float player_hp_ratio(const AppState* s) {
-    if (s->playerMaxHp <= 0) return 0.0f;
-    if (s->playerHp <= 0) return 0.0f;
-    if (s->playerHp >= s->playerMaxHp) return 1.0f;
-    return (float)s->playerHp / (float)s->playerMaxHp;
+static float player_hp_ratio(const SimHud* hud) {
+    if (hud->playerMaxHp <= 0) return 0.0f;
+    if (hud->playerHp <= 0) return 0.0f;
+    if (hud->playerHp >= hud->playerMaxHp) return 1.0f;
+    return (float)hud->playerHp / (float)hud->playerMaxHp;
 }
 
 static SDL_Texture* load_texture_from_bmp(SDL_Renderer* renderer, const char* path) {
@@ -949,14 +1019,15 @@ static void app_destroy_ui_assets(AppState* s) {
     memset(&s->ui, 0, sizeof(s->ui));
 }
 
-static void draw_survival_stats_panel(AppState* s) {
+static void draw_survival_stats_panel(AppState* s, const SimSnapshot* snap) {
+    const GameMode mode = (GameMode)snap->hud.gameMode;
     StatsPanelLayout layout;
     char topValueText[32];
     char scoreText[32];
     const char* topLabel;
 
     if (!s->showStatsPanel) return;
-    if (s->gameMode != GAMEMODE_SURVIVAL && s->gameMode != GAMEMODE_TERMINATE44) return;
+    if (mode != GAMEMODE_SURVIVAL && mode != GAMEMODE_TERMINATE44) return;
 
     layout = get_stats_panel_layout(s->winW);
 
@@ -966,26 +1037,26 @@ static void draw_survival_stats_panel(AppState* s) {
     draw_rect_outline(s->renderer, layout.x, layout.y, layout.w, layout.h);
 
     SDL_SetRenderDrawColor(s->renderer, 235, 235, 235, 255);
-    topLabel = (s->gameMode == GAMEMODE_SURVIVAL) ? "TIME" : "KILL";
+    topLabel = (mode == GAMEMODE_SURVIVAL) ? "TIME" : "KILL";
     draw_text_5x7(s->renderer, layout.x + 8, layout.y + 8, topLabel, 1);
     draw_text_5x7(s->renderer, layout.x + 8, layout.y + 32, "PTS", 1);
 
-    if (s->gameMode == GAMEMODE_SURVIVAL) {
-        snprintf(topValueText, sizeof(topValueText), "%.1f", s->survivalTime);
-        snprintf(scoreText, sizeof(scoreText), "%.1f", survival_score_from_time(s->survivalTime));
+    if (mode == GAMEMODE_SURVIVAL) {
+        snprintf(topValueText, sizeof(topValueText), "%.1f", snap->hud.survivalTime);
+        snprintf(scoreText, sizeof(scoreText), "%.1f", survival_score_from_time(snap->hud.survivalTime));
     } else {
-        snprintf(topValueText, sizeof(topValueText), "%d", s->terminateKills);
-        snprintf(scoreText, sizeof(scoreText), "%d", s->terminateKills);
+        snprintf(topValueText, sizeof(topValueText), "%d", snap->hud.terminateKills);
+        snprintf(scoreText, sizeof(scoreText), "%d", snap->hud.terminateKills);
     }
 
     draw_text_5x7(s->renderer, layout.x + 58, layout.y + 8, topValueText, 1);
     draw_text_5x7(s->renderer, layout.x + 58, layout.y + 32, scoreText, 1);
 }
 
-static void draw_health_bar_fallback(AppState* s) {
+static void draw_health_bar_fallback(AppState* s, const SimSnapshot* snap) {
     HealthBarLayout layout = get_health_bar_layout(s->winH);
     int innerW = layout.w - 12;
-    int fillW = (int)(player_hp_ratio(s) * (float)innerW + 0.5f);
+    int fillW = (int)(player_hp_ratio(&snap->hud) * (float)innerW + 0.5f);
 
     SDL_SetRenderDrawColor(s->renderer, 24, 24, 24, 255);
     draw_rect_filled(s->renderer, layout.x, layout.y, layout.w, layout.h);
@@ -999,18 +1070,18 @@ static void draw_health_bar_fallback(AppState* s) {
     draw_text_5x7(s->renderer, layout.x + 8, layout.y + layout.h - 14, "HP", 1);
 }
 
-static void draw_health_bar(AppState* s) {
+static void draw_health_bar(AppState* s, const SimSnapshot* snap) {
     HealthBarLayout layout = get_health_bar_layout(s->winH);
 
     if (!s->ui.hpBarEmpty || !s->ui.hpBarFull || !s->ui.hpHeartSheet) {
-        draw_health_bar_fallback(s);
+        draw_health_bar_fallback(s, snap);
         return;
     }
 
     {
         SDL_Rect dst = {layout.x, layout.y, layout.w, layout.h};
         SDL_Rect srcEmpty = {0, 0, s->ui.hpBarW, s->ui.hpBarH};
-        int filledSourceWidth = (int)(player_hp_ratio(s) * (float)s->ui.hpBarFillW + 0.5f);
+        int filledSourceWidth = (int)(player_hp_ratio(&snap->hud) * (float)s->ui.hpBarFillW + 0.5f);
         SDL_Rect srcFull = {s->ui.hpBarFillX, 0, filledSourceWidth, s->ui.hpBarH};
         SDL_Rect dstFull = {layout.x + s->ui.hpBarFillX * 2, layout.y, filledSourceWidth * 2, layout.h};
         int frameIndex = ((int)(s->ui.hpHeartAnimTime / 0.18)) % s->ui.hpHeartFrames;
@@ -1024,7 +1095,7 @@ static void draw_health_bar(AppState* s) {
     }
 }
 
-static void draw_ability_bar(AppState* s) {
+static void draw_ability_bar(AppState* s, const SimSnapshot* snap) {
     AbilityBarLayout layout;
 
     layout = get_ability_bar_layout(s->winW, s->winH);
@@ -1056,8 +1127,8 @@ static void draw_ability_bar(AppState* s) {
             SDL_RenderDrawLine(s->renderer, innerX + innerW / 2, innerY + 4, innerX + innerW / 2, innerY + innerH - 4);
             SDL_RenderDrawLine(s->renderer, innerX + 4, innerY + innerH / 2, innerX + innerW - 4, innerY + innerH / 2);
 
-            if (s->shockCooldown > 0.0) {
-                barH = (int)(shock_cooldown_ratio(s) * (float)innerH + 0.5f);
+            if (snap->hud.shockCooldown > 0.0) {
+                barH = (int)(shock_cooldown_ratio(&snap->hud) * (float)innerH + 0.5f);
                 SDL_SetRenderDrawColor(s->renderer, 8, 8, 8, 180);
                 draw_rect_filled(s->renderer, innerX, innerY, innerW, barH);
             }
@@ -1089,17 +1160,17 @@ static ShockwaveSettings get_shockwave_settings(GameMode mode) {
     return settings;
 }
 
-static ViewTransform make_view_transform(const AppState* s) {
+static ViewTransform make_view_transform(const AppState* s, const SimSnapshot* snap) {
     ViewTransform view = {1.0f, 0.0f, 0.0f, 6.0f};
-    const float sx = (s->world.width > 0) ? ((float)s->winW / (float)s->world.width) : 1.0f;
-    const float sy = (s->world.height > 0) ? ((float)s->winH / (float)s->world.height) : 1.0f;
+    const float sx = (snap->width > 0) ? ((float)s->winW / (float)snap->width) : 1.0f;
+    const float sy = (snap->height > 0) ? ((float)s->winH / (float)snap->height) : 1.0f;
 
     view.scale = sx < sy ? sx : sy;
     if (view.scale < 1.0f) view.scale = 1.0f;
 
     {
-        const float worldPixW = (float)s->world.width * view.scale;
-        const float worldPixH = (float)s->world.height * view.scale;
+        const float worldPixW = (float)snap->width * view.scale;
+        const float worldPixH = (float)snap->height * view.scale;
         view.offsetX = 0.5f * ((float)s->winW - worldPixW);
         view.offsetY = 0.5f * ((float)s->winH - worldPixH);
     }
@@ -1137,48 +1208,49 @@ static void draw_triangle_boid(SDL_Renderer* renderer, float px, float py, Vec2
     SDL_RenderDrawLines(renderer, pts, 4);
 }
 
-static void draw_boids(AppState* s, const ViewTransform* view) {
-    for (size_t i = 0; i < s->world.boidCount; i++) {
-        const Boid* boid = &s->world.boids[i];
+static void draw_boids(AppState* s, const SimSnapshot* snap, const ViewTransform* view) {
+    for (size_t i = 0; i < snap->boidCount; i++) {
+        Boid boid;
         float size = view->triSize;
         float px;
         float py;
 
-        if (!boid->alive) continue;
+        if (!(snap->boids.flags[i] & BOID_FLAG_ALIVE)) continue;
+        boid = boid_arrays_load(&snap->boids, i);
 
-        if (boid->predator) {
+        if (boid.predator) {
             SDL_SetRenderDrawColor(s->renderer, 255, 120, 0, 255);
             size *= 1.8f;
         } else {
-            set_group_color(s->renderer, boid->group, s->world.groupCount);
+            set_group_color(s->renderer, boid.group, snap->groupCount);
         }
 
-        px = view->offsetX + boid->pos.x * view->scale;
-        py = view->offsetY + boid->pos.y * view->scale;
-        draw_triangle_boid(s->renderer, px, py, boid->vel, size);
+        px = view->offsetX + boid.pos.x * view->scale;
+        py = view->offsetY + boid.pos.y * view->scale;
+        draw_triangle_boid(s->renderer, px, py, boid.vel, size);
     }
 }
 
-static void draw_player(AppState* s, const ViewTransform* view) {
-    float px = view->offsetX + s->world.player.pos.x * view->scale;
-    float py = view->offsetY + s->world.player.pos.y * view->scale;
+static void draw_player(AppState* s, const SimSnapshot* snap, const ViewTransform* view) {
+    float px = view->offsetX + snap->player.pos.x * view->scale;
+    float py = view->offsetY + snap->player.pos.y * view->scale;
     SDL_SetRenderDrawColor(s->renderer, 255, 255, 255, 255);
-    draw_triangle_boid(s->renderer, px, py, s->playerDir, view->triSize);
+    draw_triangle_boid(s->renderer, px, py, snap->hud.playerDir, view->triSize);
 }
 
-static void draw_shockwave_ring(AppState* s, const ViewTransform* view) {
+static void draw_shockwave_ring(AppState* s, const SimSnapshot* snap, const ViewTransform* view) {
     enum { SHOCK_RING_SEGS = 24 };
     SDL_Point pts[SHOCK_RING_SEGS + 1];
     int cx;
     int cy;
     int rr;
 
-    if (s->shockTime <= 0.0 || s->shockRadius <= 0.0f) return;
+    if (snap->hud.shockTime <= 0.0 || snap->hud.shockRadius <= 0.0f) return;
 
     SDL_SetRenderDrawColor(s->renderer, 120, 200, 255, 255);
-    cx = (int)(view->offsetX + s->world.player.pos.x * view->scale + 0.5f);
-    cy = (int)(view->offsetY + s->world.player.pos.y * view->scale + 0.5f);
-    rr = (int)(s->shockRadius * view->scale + 0.5f);
+    cx = (int)(view->offsetX + snap->player.pos.x * view->scale + 0.5f);
+    cy = (int)(view->offsetY + snap->player.pos.y * view->scale + 0.5f);
+    rr = (int)(snap->hud.shockRadius * view->scale + 0.5f);
 
     for (int i = 0; i <= SHOCK_RING_SEGS; i++) {
         float angle = (float)i * (6.2831853f / (float)SHOCK_RING_SEGS);
@@ -1189,23 +1261,32 @@ static void draw_shockwave_ring(AppState* s, const ViewTransform* view) {
     SDL_RenderDrawLines(s->renderer, pts, SHOCK_RING_SEGS + 1);
 }
 
-static float frand01_local(void) {
-    return (float)rand() / (float)RAND_MAX;
+static Vec2 rand_unit_dir(uint64_t seed, uint64_t index) {
+    float a = boids_rng_float01(seed, BENCH_RNG_STREAM_PREDATORS, index) * 6.2831853f;
+    return (Vec2){cosf(a), sinf(a)};
 }
 
-static Vec2 rand_unit_dir(void) {
-    float a = frand01_local() * 6.2831853f;
-    return (Vec2){cosf(a), sinf(a)};
+/* the updater's workers when there are any, NULL (serial) otherwise */
+static const WorldParallel* app_world_parallel(AppState* s, WorldParallel* storage) {
+    if (!s->updaterInited) return NULL;
+    return updater_parallel(&s->updater, storage);
 }
 
-static void app_reset_world_for_mode(AppState* s) {
-    if (!s) return;
+static bool app_reset_world_for_mode(AppState* s) {
+    if (!s) return false;
     World tmp;
-    if (!world_init(&tmp, s->cfg.width, s->cfg.height, (size_t)s->cfg.boidCount)) {
-        return;
+    WorldParallel par;
+    /* every reset gets a fresh world, but the sequence of worlds is fixed by cfg.run.seed */
+    uint64_t seed = bench_world_seed(s->cfg.run.seed, s->resetCount);
+    if (!world_init(&tmp, s->cfg.run.width, s->cfg.run.height, (size_t)s->cfg.run.boidCount, seed, app_world_parallel(s, &par))) {
+        return false;
     }
+    s->resetCount++;
+    s->worldSeed = seed;
     world_destroy(&s->world);
     s->world = tmp;
+    s->world.profiler = s->profiler;
+    bench_world_configure(&s->world, &s->cfg.run);
 
     /* reset ability + counters */
     s->shockCooldown = 0.0;
@@ -1222,9 +1303,9 @@ static void app_reset_world_for_mode(AppState* s) {
         int predCount = 6;
         if ((int)s->world.boidCount < predCount) predCount = (int)s->world.boidCount;
         for (int i = 0; i < predCount; i++) {
-            Boid* b = &s->world.boids[i];
-            b->predator = 1;
-            b->alive = 1;
+            Boid b = world_get_boid(&s->world, i);
+            b.predator = 1;
+            b.alive = 1;
 
             /* spawn predators away from the player to avoid instant game-over loops */
             const float px = s->world.player.pos.x;
@@ -1238,53 +1319,27 @@ static void app_reset_world_for_mode(AppState* s) {
                 {ww - 3.0f, hh - 3.0f},
             };
             Vec2 c = corners[i % 4];
-            b->pos = c;
+            b.pos = c;
             (void)px; (void)py;
 
-            Vec2 d = rand_unit_dir();
-            b->vel = (Vec2){d.x * 28.0f, d.y * 28.0f};
+            Vec2 d = rand_unit_dir(s->worldSeed, (uint64_t)i);
+            b.vel = (Vec2){d.x * 28.0f, d.y * 28.0f};
+            world_set_boid(&s->world, (size_t)i, &b);
         }
     }
+    world_update_population(&s->world);
+    return true;
 }
 
-static void apply_shockwave(World* w, double dt, float radius, float strength) {
-    if (!w) return;
-    if (radius <= 0.0f || strength <= 0.0f) return;
-    (void)dt;
-
-    const float ww = (float)w->width;
-    const float hh = (float)w->height;
-    const float r2 = radius * radius;
-    const float eps = 1e-6f;
-
-    for (size_t i = 0; i < w->boidCount; i++) {
-        Boid* b = &w->boids[i];
-        if (!b->alive) continue;
-
-        float dx = torus_delta_f(b->pos.x - w->player.pos.x, ww);
-        float dy = torus_delta_f(b->pos.y - w->player.pos.y, hh);
-        float d2 = dx * dx + dy * dy;
-        if (d2 >= r2 || d2 < eps) continue;
-
-        float d = sqrtf(d2);
-        float t = (radius - d) / radius;
-        /* impulse (not acceleration): make it feel immediate */
-        float k = (strength * t);
-        b->vel.x += (dx / d) * k;
-        b->vel.y += (dy / d) * k;
-    }
-}
-
+/* sim thread: follows the window size last sent through SIM_CMD_VIEW */
 static void app_update_world_bounds_for_window(AppState* s) {
-    if (!s || !s->window) return;
+    if (!s) return;
     if (s->targetPixelsPerUnit <= 0.5f) s->targetPixelsPerUnit = 10.0f;
 
-    int cw = 0, ch = 0;
-    SDL_GetWindowSize(s->window, &cw, &ch);
-    if (cw <= 1 || ch <= 1) return;
+    if (s->viewW <= 1 || s->viewH <= 1) return;
 
-    int drawW = cw;
-    int drawH = ch;
+    int drawW = s->viewW;
+    int drawH = s->viewH;
 
     int desiredW = (int)((float)drawW / s->targetPixelsPerUnit);
     int desiredH = (int)((float)drawH / s->targetPixelsPerUnit);
@@ -1293,27 +1348,17 @@ static void app_update_world_bounds_for_window(AppState* s) {
     if (desiredW < 10) desiredW = 10;
     if (desiredH < 10) desiredH = 10;
 
-    if (s->world.width != desiredW || s->world.height != desiredH) {
-        s->world.width = desiredW;
-        s->world.height = desiredH;
-        if (s->world.width > 0) {
-            float w = (float)s->world.width;
-            while (s->world.player.pos.x >= w) s->world.player.pos.x -= w;
-            while (s->world.player.pos.x < 0) s->world.player.pos.x += w;
-        }
-        if (s->world.height > 0) {
-            float h = (float)s->world.height;
-            while (s->world.player.pos.y >= h) s->world.player.pos.y -= h;
-            while (s->world.player.pos.y < 0) s->world.player.pos.y += h;
-        }
-    }
+    world_set_size(&s->world, desiredW, desiredH);
 }
 
-static void input_set_key(InputState* in, SDL_Keycode key, bool down) {
+/* returns true for the movement keys */
+static bool input_set_key(InputState* in, SDL_Keycode key, bool down) {
     if (key == SDLK_w) in->up = down;
-    if (key == SDLK_s) in->down = down;
-    if (key == SDLK_a) in->left = down;
-    if (key == SDLK_d) in->right = down;
+    else if (key == SDLK_s) in->down = down;
+    else if (key == SDLK_a) in->left = down;
+    else if (key == SDLK_d) in->right = down;
+    else return false;
+    return true;
 }
 
 static void set_group_color(SDL_Renderer* r, unsigned char group, int groupCount) {
@@ -1342,36 +1387,62 @@ static void set_group_color(SDL_Renderer* r, unsigned char group, int groupCount
     SDL_SetRenderDrawColor(r, palette[idx][0], palette[idx][1], palette[idx][2], 255);
 }
 
-static void draw_world_sdl(AppState* s) {
+static void app_send_command(AppState* s, const SimCommand* cmd) {
+    if (!sim_command_push(&s->sim->commands, cmd)) {
+        fprintf(stderr, "Warning: sim command queue full, input dropped.\n");
+    }
+}
+
+static void draw_world_sdl(AppState* s, const SimSnapshot* snap) {
     ViewTransform view;
+    PhaseLap lap;
+    int prevW;
+    int prevH;
 
-    if (!s || !s->renderer || !s->window) return;
+    if (!s || !s->renderer || !s->window || !snap) return;
 
+    lap = profiler_lap_start(s->profiler);
+    prevW = s->winW;
+    prevH = s->winH;
     SDL_GetWindowSize(s->window, &s->winW, &s->winH);
-    app_update_world_bounds_for_window(s);
-    view = make_view_transform(s);
+    if (s->winW != prevW || s->winH != prevH) {
+        SimCommand cmd = {.type = SIM_CMD_VIEW};
+        cmd.u.view.w = s->winW;
+        cmd.u.view.h = s->winH;
+        app_send_command(s, &cmd);
+    }
+    view = make_view_transform(s, snap);
 
     SDL_SetRenderDrawColor(s->renderer, 0, 0, 0, 255);
     SDL_RenderClear(s->renderer);
-
-    draw_mode_dropdown(s);
-    draw_survival_stats_panel(s);
-    draw_health_bar(s);
-
-    draw_boids(s, &view);
-    draw_player(s, &view);
-    draw_shockwave_ring(s, &view);
-    draw_ability_bar(s);
+    profiler_lap(&lap, PROF_DRAW_CLEAR);
+
+    draw_mode_dropdown(s, snap);
+    profiler_lap(&lap, PROF_DRAW_DROPDOWN);
+    draw_survival_stats_panel(s, snap);
+    profiler_lap(&lap, PROF_DRAW_STATS);
+    draw_health_bar(s, snap);
+    profiler_lap(&lap, PROF_DRAW_HEALTH);
+
+    draw_boids(s, snap, &view);
+    profiler_lap(&lap, PROF_DRAW_BOIDS);
+    draw_player(s, snap, &view);
+    profiler_lap(&lap, PROF_DRAW_PLAYER);
+    draw_shockwave_ring(s, snap, &view);
+    profiler_lap(&lap, PROF_DRAW_RING);
+    draw_ability_bar(s, snap);
+    profiler_lap(&lap, PROF_DRAW_ABILITY);
 
     SDL_RenderPresent(s->renderer);
+    profiler_lap(&lap, PROF_DRAW_PRESENT);
 }
 
 static AppState app_make_initial_state(AppConfig cfg) {
     AppState state;
     memset(&state, 0, sizeof(state));
     state.cfg = cfg;
-    state.baseWorldW = cfg.width;
-    state.baseWorldH = cfg.height;
+    state.baseWorldW = cfg.run.width;
+    state.baseWorldH = cfg.run.height;
     state.targetPixelsPerUnit = 10.0f;
     state.playerDir = (Vec2){1.0f, 0.0f};
     state.gameMode = cfg.gameMode;
@@ -1383,20 +1454,17 @@ static AppState app_make_initial_state(AppConfig cfg) {
 }
 
 static bool app_create_world_and_updater(AppState* s) {
-    if (!world_init(&s->world, s->cfg.width, s->cfg.height, (size_t)s->cfg.boidCount)) {
-        fprintf(stderr, "world_init failed\n");
+    /* the updater (pinned for --pin) comes first so its workers can fill the world */
+    if (!bench_updater_init(&s->updater, &s->cfg.run)) {
         return false;
     }
+    s->updaterInited = true;
 
-    app_reset_world_for_mode(s);
-
-    if (s->cfg.mode == RUNMODE_PTHREAD) {
-        if (!update_pthreads_init(&s->updater, (size_t)s->cfg.threadCount)) {
-            fprintf(stderr, "update_pthreads_init failed\n");
-            world_destroy(&s->world);
-            return false;
-        }
-        s->updaterInited = true;
+    if (!app_reset_world_for_mode(s)) {
+        fprintf(stderr, "world_init failed\n");
+        updater_destroy(&s->updater);
+        s->updaterInited = false;
+        return false;
     }
 
     return true;
@@ -1404,8 +1472,8 @@ static bool app_create_world_and_updater(AppState* s) {
 
 static bool app_create_window_and_renderer(AppState* s) {
     const int scale = 10;
-    const int winW = s->cfg.width * scale;
-    const int winH = s->cfg.height * scale;
+    const int winW = s->cfg.run.width * scale;
+    const int winH = s->cfg.run.height * scale;
 
     s->window = SDL_CreateWindow(
         "Boids (SDL2)",
@@ -1440,8 +1508,20 @@ static void app_destroy(AppState* s) {
     app_destroy_ui_assets(s);
     if (s->renderer) SDL_DestroyRenderer(s->renderer);
     if (s->window) SDL_DestroyWindow(s->window);
-    if (s->updaterInited) update_pthreads_destroy(&s->updater);
+    if (s->updaterInited) updater_destroy(&s->updater);
     world_destroy(&s->world);
+    free(s->profiler);
+    s->profiler = NULL;
+}
+
+/* phase times from here on, for the sim phases, the updater's tick phases and the draw steps */
+static bool app_enable_profiler(AppState* s) {
+    if (s->profiler) return true;
+    s->profiler = (PhaseProfiler*)malloc(sizeof(PhaseProfiler));
+    if (!s->profiler) return false;
+    profiler_init(s->profiler);
+    s->world.profiler = s->profiler;
+    return true;
 }
 
 static void app_handle_mouse_click(AppState* s, const SDL_MouseButtonEvent* button) {
@@ -1457,18 +1537,23 @@ static void app_handle_mouse_click(AppState* s, const SDL_MouseButtonEvent* butt
     }
 
     if (s->menuOpen && pt_in_rect(button->x, button->y, layout.listX, layout.listY, layout.listW, layout.listH)) {
+        SimCommand cmd = {.type = SIM_CMD_MODE};
         index = (button->y - layout.listY) / layout.itemH;
         if (index < 0) index = 0;
         if (index > 2) index = 2;
-        s->pendingMode = (GameMode)index;
-        s->pendingModeChange = true;
+        cmd.u.mode = index;
+        app_send_command(s, &cmd);
     }
 
     s->menuOpen = false;
 }
 
 static void app_handle_key(AppState* s, SDL_Keycode key, bool down) {
-    input_set_key(&s->input, key, down);
+    if (input_set_key(&s->keys, key, down)) {
+        SimCommand cmd = {.type = SIM_CMD_INPUT};
+        cmd.u.input = s->keys;
+        app_send_command(s, &cmd);
+    }
 
     if (!down) return;
 
@@ -1478,7 +1563,8 @@ static void app_handle_key(AppState* s, SDL_Keycode key, bool down) {
     }
 
     if (key == SDLK_SPACE || key == ' ') {
-        s->shockRequest = true;
+        SimCommand cmd = {.type = SIM_CMD_SHOCK};
+        app_send_command(s, &cmd);
     }
 
     if (key == SDLK_ESCAPE || key == SDLK_q) {
@@ -1493,8 +1579,6 @@ static void app_handle_event(AppState* s, const SDL_Event* e) {
         app_handle_mouse_click(s, &e->button);
     } else if (e->type == SDL_KEYDOWN || e->type == SDL_KEYUP) {
         app_handle_key(s, e->key.keysym.sym, e->type == SDL_KEYDOWN);
-    } else if (e->type == SDL_WINDOWEVENT && e->window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
-        app_update_world_bounds_for_window(s);
     }
 }
 
@@ -1527,6 +1611,7 @@ static void app_update_player_direction(AppState* s) {
 
 static void app_update_shockwave(AppState* s, double simDt) {
     ShockwaveSettings settings = get_shockwave_settings(s->gameMode);
+    WorldParallel par;
 
     if (s->shockCooldown > 0.0) s->shockCooldown -= simDt;
     if (s->shockTime > 0.0) s->shockTime -= simDt;
@@ -1536,158 +1621,787 @@ static void app_update_shockwave(AppState* s, double simDt) {
             s->shockTime = 0.18;
             s->shockCooldown = 1.00;
             s->shockRadius = settings.radius;
-            apply_shockwave(&s->world, simDt, settings.radius, settings.strength);
+            world_apply_shockwave(&s->world, settings.radius, settings.strength, app_world_parallel(s, &par));
         }
         s->shockRequest = false;
     }
 
     if (s->shockTime > 0.0) {
-        apply_shockwave(&s->world, simDt, s->shockRadius, settings.strength);
+        world_apply_shockwave(&s->world, s->shockRadius, settings.strength, app_world_parallel(s, &par));
     }
+}
+
+/*
+   The actual parallelization enters here, through the backend picked by --mode:
+   - seq: world_prepare_step + world_step_range + world_swap_buffers
+   - pthread: update_pthreads_step
+   - openmp: update_openmp_step
+*/
+static void app_step_boids(AppState* s, double simDt) {
+    TRACE_BEGIN(t0);
+    updater_step(&s->updater, &s->world, simDt);
+    TRACE_END(t0, "tick");
+}
 
-    s->ui.hpHeartAnimTime += simDt;
+static bool app_prepare_benchmark_state(AppState* s, AppConfig cfg) {
+    *s = app_make_initial_state(cfg);
+    return app_create_world_and_updater(s);
+}
+
+static BenchTarget app_bench_target(AppState* s) {
+    return (BenchTarget){&s->world, &s->updater};
+}
+
+static BenchmarkResult app_run_benchmark(AppState* s) {
+    BenchTarget t = app_bench_target(s);
+    return bench_run(&t, &s->cfg.run);
+}
+
+static void print_benchmark_result(const AppConfig* cfg, const BenchmarkResult* result) {
+    bench_print_result(&cfg->run, game_mode_name(cfg->gameMode), result);
+}
+
+static void print_thread_stats(const AppState* s) {
+    if (s->updaterInited) bench_print_thread_stats(&s->updater);
+}
+
+/* the BenchDriver of the shared runners: one AppState at a time, built the way the game builds it */
+typedef struct AppBenchDriver {
+    AppConfig cfg;
+    AppState state;
+} AppBenchDriver;
+
+static bool app_bench_create(void* ctx, const BenchOptions* o, BenchTarget* out) {
+    AppBenchDriver* d = (AppBenchDriver*)ctx;
+    AppConfig cfg = d->cfg;
+
+    cfg.run = *o;
+    if (!app_prepare_benchmark_state(&d->state, cfg)) return false;
+    *out = app_bench_target(&d->state);
+    return true;
+}
+
+static void app_bench_destroy(void* ctx) {
+    app_destroy(&((AppBenchDriver*)ctx)->state);
+}
+
+static BenchDriver app_bench_driver(AppBenchDriver* d, const AppConfig* cfg) {
+    d->cfg = *cfg;
+    return (BenchDriver){game_mode_name(cfg->gameMode), d, app_bench_create, app_bench_destroy};
+}
+
+static int run_single_benchmark(const AppConfig* cfg) {
+    AppBenchDriver d;
+    const BenchDriver driver = app_bench_driver(&d, cfg);
+    return bench_run_single(&cfg->run, &driver);
+}
+
+static int run_compare_benchmark(const AppConfig* cfg) {
+    AppBenchDriver d;
+    const BenchDriver driver = app_bench_driver(&d, cfg);
+    return bench_run_compare(&cfg->run, &driver);
+}
+
+/* main thread waiting for N workers vs main thread + N - 1 workers, at several thread counts */
+static int run_caller_compare_benchmark(const AppConfig* cfg) {
+    const int threadCounts[] = {1, 2, 4, 8};
+
+    for (size_t t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); t++) {
+        BenchmarkResult results[2];
+
+        for (int works = 0; works < 2; works++) {
+            AppConfig runCfg = *cfg;
+            AppState state;
+
+            runCfg.run.mode = UPDATER_PTHREAD;
+            runCfg.run.threadCount = threadCounts[t];
+            runCfg.run.callerWorks = works != 0;
+            if (!app_prepare_benchmark_state(&state, runCfg)) {
+                return 1;
+            }
+            results[works] = app_run_benchmark(&state);
+            app_destroy(&state);
+        }
+
+        bench_printf("caller threads=%d boids=%d steps=%d wait=%.3f ms/tick work=%.3f ms/tick change=%+.1f%%\n",
+                     threadCounts[t],
+                     cfg->run.boidCount,
+                     cfg->run.benchmarkSteps,
+                     results[0].avgMs,
+                     results[1].avgMs,
+                     results[0].avgMs > 0.0 ? 100.0 * (results[1].avgMs - results[0].avgMs) / results[0].avgMs : 0.0);
+    }
+
+    return 0;
 }
 
 /*
-   The actual parallelization enters here.
-   - seq path: world_step_range + world_swap_buffers
-   - pthread path: update_pthreads_step
+   Same world stepped tick by tick from the main thread and in one update_pthreads_run batch;
+   the difference is what the per-tick hand-off to the workers and back costs.
 */
-static void app_step_boids_seq(AppState* s, double simDt) {
-    world_step_range(&s->world, &s->world, 0, s->world.boidCount, simDt);
-    world_swap_buffers(&s->world);
+static int run_batch_compare_benchmark(const AppConfig* cfg) {
+    BenchmarkResult results[2];
+
+    for (int batch = 0; batch < 2; batch++) {
+        AppConfig runCfg = *cfg;
+        AppState state;
+
+        runCfg.run.mode = UPDATER_PTHREAD;
+        runCfg.run.batchTicks = batch != 0;
+        if (!app_prepare_benchmark_state(&state, runCfg)) {
+            return 1;
+        }
+        results[batch] = app_run_benchmark(&state);
+        print_benchmark_result(&runCfg, &results[batch]);
+        print_thread_stats(&state);
+        app_destroy(&state);
+    }
+
+    bench_printf("batch threads=%d boids=%d steps=%d per_tick=%.3f ms/tick batch=%.3f ms/tick orchestration=%.3f ms/tick (%.1f%%)\n",
+                 cfg->run.threadCount,
+                 cfg->run.boidCount,
+                 cfg->run.benchmarkSteps,
+                 results[0].avgMs,
+                 results[1].avgMs,
+                 results[0].avgMs - results[1].avgMs,
+                 results[0].avgMs > 0.0 ? 100.0 * (results[0].avgMs - results[1].avgMs) / results[0].avgMs : 0.0);
+    return 0;
 }
 
-static void app_step_boids_pthread(AppState* s, double simDt) {
-    update_pthreads_step(&s->updater, &s->world, simDt);
+/* same world with every step schedule */
+static int run_schedule_compare_benchmark(const AppConfig* cfg) {
+    const UpdateSchedule schedules[] = {UPDATE_SCHEDULE_STATIC, UPDATE_SCHEDULE_CHUNKED, UPDATE_SCHEDULE_COST};
+
+    for (size_t i = 0; i < sizeof(schedules) / sizeof(schedules[0]); i++) {
+        AppConfig runCfg = *cfg;
+        AppState state;
+        BenchmarkResult result;
+
+        runCfg.run.mode = UPDATER_PTHREAD;
+        runCfg.run.schedule = schedules[i];
+        if (!app_prepare_benchmark_state(&state, runCfg)) {
+            return 1;
+        }
+        result = app_run_benchmark(&state);
+        print_benchmark_result(&runCfg, &result);
+        print_thread_stats(&state);
+        app_destroy(&state);
+    }
+
+    return 0;
 }
 
-static void app_step_boids(AppState* s, double simDt) {
-    if (s->cfg.mode == RUNMODE_SEQ) {
-        app_step_boids_seq(s, simDt);
+static int sweep_next(const SweepRange* r, int value) {
+    const long next = (long)value * (long)r->factor;
+    return next > (long)r->hi ? 0 : (int)next;
+}
+
+/* one point of the sweep; the world grows with the boids so the density of cfg stays the same */
+static bool sweep_measure(const AppConfig* cfg, UpdaterKind mode, int threads, int boids, double* outMs, double* outWorkMs) {
+    const double scale = sqrt((double)boids / (double)cfg->run.boidCount);
+    AppConfig runCfg = *cfg;
+    AppState state;
+    BenchmarkResult result;
+    double busyMs = 0.0;
+
+    runCfg.run.mode = mode;
+    runCfg.run.threadCount = threads;
+    runCfg.run.boidCount = boids;
+    runCfg.run.width = (int)lround(cfg->run.width * scale);
+    runCfg.run.height = (int)lround(cfg->run.height * scale);
+    if (runCfg.run.width < 11) runCfg.run.width = 11;
+    if (runCfg.run.height < 11) runCfg.run.height = 11;
+    if (!app_prepare_benchmark_state(&state, runCfg)) {
+        return false;
+    }
+    result = app_run_benchmark(&state);
+
+    /* W: summed busy time of the workers, the serial time for seq */
+    if (state.updater.ops->thread_stats) {
+        for (size_t i = 0; i < state.updater.threadCount; i++) {
+            UpdateThreadStats st;
+            if (!state.updater.ops->thread_stats(&state.updater, i, &st)) break;
+            busyMs += st.busyMs;
+        }
+        busyMs /= (double)runCfg.run.benchmarkSteps;
     } else {
-        app_step_boids_pthread(s, simDt);
+        busyMs = result.avgMs;
+    }
+    app_destroy(&state);
+
+    *outMs = result.avgMs;
+    *outWorkMs = busyMs;
+    return true;
+}
+
+/* seq time per boid count, measured once and shared by the strong and weak rows */
+typedef struct SweepSeqCache {
+    int boids[64];
+    double ms[64];
+    size_t count;
+} SweepSeqCache;
+
+static bool sweep_seq_ms(const AppConfig* cfg, SweepSeqCache* cache, int boids, double* outMs) {
+    double workMs;
+
+    for (size_t i = 0; i < cache->count; i++) {
+        if (cache->boids[i] == boids) {
+            *outMs = cache->ms[i];
+            return true;
+        }
     }
+    if (!sweep_measure(cfg, UPDATER_SEQ, 1, boids, outMs, &workMs)) return false;
+    if (cache->count < sizeof(cache->boids) / sizeof(cache->boids[0])) {
+        cache->boids[cache->count] = boids;
+        cache->ms[cache->count] = *outMs;
+        cache->count++;
+    }
+    return true;
 }
 
-static BenchmarkResult app_run_benchmark(AppState* s, int warmupSteps, int measureSteps, double simDt) {
-    BenchmarkResult result = {0};
+static void sweep_emit(FILE* f, const char* line) {
+    bench_write_text(line);
+    if (f) fputs(line, f);
+}
 
-    for (int i = 0; i < warmupSteps; i++) {
-        app_step_boids(s, simDt);
+/*
+   --sweep: strong scaling over the full threads x boids matrix, then weak scaling where the
+   boids grow with the threads from the smallest boid count. Columns follow erew_metrics.csv,
+   in ms/tick: T1 seq, Tp parallel, W summed worker busy time, C = p * Tp, S = T1 / Tp,
+   E = S / p. Ew is the weak-scaling efficiency T(lo boids, seq) / Tp.
+*/
+static int run_sweep_benchmark(const AppConfig* cfg) {
+    const UpdaterKind mode = cfg->run.mode == UPDATER_SEQ ? UPDATER_PTHREAD : cfg->run.mode;
+    SweepSeqCache cache = {{0}, {0}, 0};
+    FILE* f = NULL;
+    char line[256];
+    double baseMs = 0.0;
+
+    if (cfg->run.benchOutPath) {
+        f = fopen(cfg->run.benchOutPath, "w");
+        if (!f) {
+            fprintf(stderr, "Could not write %s\n", cfg->run.benchOutPath);
+            return 1;
+        }
     }
 
-    {
-        uint64_t t0 = time_now_us();
-        for (int i = 0; i < measureSteps; i++) {
-            app_step_boids(s, simDt);
+    bench_printf("benchmark sweep mode=%s game=%s kernel=%s steps=%d threads=%d..%d*%d boids=%d..%d*%d density=%d/%dx%d\n",
+                 updater_kind_name(mode),
+                 game_mode_name(cfg->gameMode),
+                 boids_kernel_name(cfg->run.kernel),
+                 cfg->run.benchmarkSteps,
+                 cfg->sweepThreads.lo,
+                 cfg->sweepThreads.hi,
+                 cfg->sweepThreads.factor,
+                 cfg->sweepBoids.lo,
+                 cfg->sweepBoids.hi,
+                 cfg->sweepBoids.factor,
+                 cfg->run.boidCount,
+                 cfg->run.width,
+                 cfg->run.height);
+    sweep_emit(f, "scaling,n,T1,Tp,p,W,C,S,E,Ew\n");
+
+    for (int n = cfg->sweepBoids.lo; n > 0; n = sweep_next(&cfg->sweepBoids, n)) {
+        double t1;
+
+        if (!sweep_seq_ms(cfg, &cache, n, &t1)) {
+            if (f) fclose(f);
+            return 1;
+        }
+        for (int p = cfg->sweepThreads.lo; p > 0; p = sweep_next(&cfg->sweepThreads, p)) {
+            double tp;
+            double w;
+            double speedup;
+
+            if (!sweep_measure(cfg, mode, p, n, &tp, &w)) {
+                if (f) fclose(f);
+                return 1;
+            }
+            speedup = tp > 0.0 ? t1 / tp : 0.0;
+            snprintf(line, sizeof(line), "strong,%d,%.4f,%.4f,%d,%.4f,%.4f,%.4f,%.4f,\n",
+                     n, t1, tp, p, w, (double)p * tp, speedup, speedup / (double)p);
+            sweep_emit(f, line);
         }
-        uint64_t t1 = time_now_us();
-        result.totalMs = (double)(t1 - t0) / 1000.0;
     }
 
-    if (measureSteps > 0) {
-        result.avgMs = result.totalMs / (double)measureSteps;
+    if (!sweep_seq_ms(cfg, &cache, cfg->sweepBoids.lo, &baseMs)) {
+        if (f) fclose(f);
+        return 1;
     }
-    if (result.totalMs > 0.0) {
-        result.ticksPerSecond = (double)measureSteps * 1000.0 / result.totalMs;
+    for (int p = cfg->sweepThreads.lo; p > 0; p = sweep_next(&cfg->sweepThreads, p)) {
+        const long grown = (long)cfg->sweepBoids.lo * (long)p;
+        const int n = grown > 100000000L ? 100000000 : (int)grown;
+        double t1;
+        double tp;
+        double w;
+        double speedup;
+
+        if (!sweep_seq_ms(cfg, &cache, n, &t1) || !sweep_measure(cfg, mode, p, n, &tp, &w)) {
+            if (f) fclose(f);
+            return 1;
+        }
+        speedup = tp > 0.0 ? t1 / tp : 0.0;
+        snprintf(line, sizeof(line), "weak,%d,%.4f,%.4f,%d,%.4f,%.4f,%.4f,%.4f,%.4f\n",
+                 n, t1, tp, p, w, (double)p * tp, speedup, speedup / (double)p, tp > 0.0 ? baseMs / tp : 0.0);
+        sweep_emit(f, line);
     }
 
-    return result;
+    if (f && fclose(f) != 0) {
+        fprintf(stderr, "Could not write %s\n", cfg->run.benchOutPath);
+        return 1;
+    }
+    return 0;
 }
 
-static bool app_prepare_benchmark_state(AppState* s, AppConfig cfg, unsigned seed) {
-    *s = app_make_initial_state(cfg);
-    srand(seed);
-    return app_create_world_and_updater(s);
+/*
+   Locality benchmark: the same run without and with the periodic Morton re-sort.
+   Tick time and LLC misses both cover the measured ticks, the misses summed over the updater threads.
+*/
+static int run_morton_compare_benchmark(const AppConfig* cfg) {
+    const int sortedInterval = cfg->run.mortonInterval > 0 ? cfg->run.mortonInterval : 20;
+    char text[512];
+
+    for (int variant = 0; variant < 2; variant++) {
+        AppConfig runCfg = *cfg;
+        AppState state;
+        BenchmarkResult result;
+        BenchTarget target;
+        PerfCounterValues misses;
+        char missText[64];
+
+        runCfg.run.mortonInterval = variant == 0 ? 0 : sortedInterval;
+        if (!app_prepare_benchmark_state(&state, runCfg)) {
+            return 1;
+        }
+        target = app_bench_target(&state);
+        result = bench_run_counted(&target, &runCfg.run, PERF_COUNTER_MASK(PERF_COUNTER_LLC_MISSES), &misses);
+        app_destroy(&state);
+
+        if (misses.valid[PERF_COUNTER_LLC_MISSES] && runCfg.run.benchmarkSteps > 0) {
+            snprintf(missText, sizeof(missText), "%.0f",
+                     misses.value[PERF_COUNTER_LLC_MISSES] / (double)runCfg.run.benchmarkSteps);
+        } else {
+            snprintf(missText, sizeof(missText), "n/a");
+        }
+
+        snprintf(text, sizeof(text),
+                 "benchmark morton=%d mode=%s game=%s kernel=%s threads=%d boids=%d size=%dx%d steps=%d avg=%.3f ms/tick ticks=%.2f/s cache_misses/tick=%s\n",
+                 runCfg.run.mortonInterval,
+                 updater_kind_name(runCfg.run.mode),
+                 game_mode_name(runCfg.gameMode),
+                 boids_kernel_name(runCfg.run.kernel),
+                 runCfg.run.threadCount,
+                 runCfg.run.boidCount,
+                 runCfg.run.width,
+                 runCfg.run.height,
+                 runCfg.run.benchmarkSteps,
+                 result.avgMs,
+                 result.ticksPerSecond,
+                 missText);
+        bench_write_text(text);
+    }
+
+    return 0;
 }
 
-static void print_benchmark_result(const AppConfig* cfg, const BenchmarkResult* result) {
+/* work range of run_sync_benchmark: nothing to do, so only the handoff is timed */
+static void empty_part(void* arg, size_t part, size_t partCount) {
+    (void)arg;
+    (void)part;
+    (void)partCount;
+}
+
+/* pure fork-join cost of the pthread updater: every handoff runs an empty work range */
+static int run_sync_benchmark(const AppConfig* cfg) {
+    /* -1 = the updater's own choice */
+    const int spins[] = {-1, 0, 64, 1024, SPIN_BARRIER_DEFAULT_SPIN};
+    const int spinCount = (int)(sizeof(spins) / sizeof(spins[0]));
+    const int variantCount = spinCount + (cfg->run.spinLimit >= 0 ? 1 : 0);
+
+    for (int variant = 0; variant < variantCount; variant++) {
+        const int spin = variant < spinCount ? spins[variant] : cfg->run.spinLimit;
+        UpdatePthreads updater;
+        WorldParallel par;
+        char spinText[16];
+
+        if (!update_pthreads_init(&updater, (size_t)cfg->run.threadCount, cfg->run.callerWorks)) {
+            fprintf(stderr, "update_pthreads_init failed\n");
+            return 1;
+        }
+        if (spin >= 0) update_pthreads_set_spin(&updater, (unsigned)spin);
+        par = update_pthreads_parallel(&updater);
+        if (spin >= 0) snprintf(spinText, sizeof(spinText), "%d", spin);
+        else snprintf(spinText, sizeof(spinText), "default");
+
+        for (int i = 0; i < cfg->run.benchmarkWarmup; i++) par.run(par.ctx, empty_part, NULL);
+        uint64_t t0 = time_now_us();
+        for (int i = 0; i < cfg->run.benchmarkSteps; i++) par.run(par.ctx, empty_part, NULL);
+        uint64_t t1 = time_now_us();
+        update_pthreads_destroy(&updater);
+
+        const double totalMs = (double)(t1 - t0) / 1000.0;
+        bench_printf("sync mode=pthread threads=%d spin=%s handoffs=%d total=%.3f ms avg=%.2f us/handoff\n",
+                     cfg->run.threadCount,
+                     spinText,
+                     cfg->run.benchmarkSteps,
+                     totalMs,
+                     totalMs * 1000.0 / (double)cfg->run.benchmarkSteps);
+    }
+
+    return 0;
+}
+
+/*
+   Grid scan with cfg->run.kernel, the same scan with the scalar loop, then Verlet lists at several
+   skins. The list walk is scalar, so the scalar grid row is the like-for-like baseline.
+*/
+static int run_verlet_compare_benchmark(const AppConfig* cfg) {
+    const float skins[] = {0.0f, 0.5f, 1.0f, 1.5f, 2.0f, 3.0f};
+    const int gridVariants = cfg->run.kernel == BOID_KERNEL_SCALAR ? 1 : 2;
+    const int variantCount = gridVariants + (int)(sizeof(skins) / sizeof(skins[0]));
+
+    for (int variant = 0; variant < variantCount; variant++) {
+        AppConfig runCfg = *cfg;
+        AppState state;
+        BenchmarkResult result;
+
+        runCfg.run.verletLists = variant >= gridVariants;
+        runCfg.run.verletSkin = runCfg.run.verletLists ? skins[variant - gridVariants] : 0.0f;
+        if (variant > 0) runCfg.run.kernel = BOID_KERNEL_SCALAR;
+        if (!app_prepare_benchmark_state(&state, runCfg)) {
+            return 1;
+        }
+        result = app_run_benchmark(&state);
+        print_benchmark_result(&runCfg, &result);
+        app_destroy(&state);
+    }
+
+    return 0;
+}
+
+/*
+   Scripted player of the lockstep checks: diagonal runs that turn every 90 ticks and a shockwave
+   every 240, fed to both worlds before the full game tick (app_step_simulation). So the game
+   rules run too: kills and hits from the step, their tally reduction, world_compact_dead and
+   the survival resets.
+*/
+static void app_script_check_tick(AppState* s, int step, double simDt) {
+    static const InputState runs[4] = {
+        {false, true, false, true},
+        {true, false, false, true},
+        {false, true, true, false},
+        {true, false, true, false},
+    };
+
+    s->input = runs[(step / 90) % 4];
+    s->shockRequest = step % 240 == 120;
+    app_step_simulation(s, simDt);
+}
+
+/* the outcome of a tick the game acts on; withPairs also compares the neighbor candidates looked at */
+static const char* tally_mismatch(const WorldStepTally* a, const WorldStepTally* b, bool withPairs) {
+    if (a->kills != b->kills) return "tally.kills";
+    if (a->hits != b->hits) return "tally.hits";
+    if (withPairs && a->pairs != b->pairs) return "tally.pairs";
+    return NULL;
+}
+
+/*
+   Equivalence test of two ways to step the same world: a reference and a checked world are
+   stepped from the same seed, and after every tick the deviation is measured and the checked
+   world is resynced to the reference state, so float rounding cannot accumulate. Both play the
+   scripted game tick (app_script_check_tick); a tick whose tally or population differs ends the
+   check as failed. withPairs: both look at the same neighbor candidates.
+*/
+static int run_resync_check(const char* what, const AppConfig* refCfg, const AppConfig* testCfg, bool withPairs,
+                            double simDt) {
+    const AppConfig* cfg = testCfg;
+    const float tolerance = 1e-3f;
+    AppState refState;
+    AppState testState;
+    float maxDiff = 0.0f;
+    int worstStep = -1;
+    const char* tallyField = NULL;
+    int tallyStep = -1;
+    unsigned long kills = 0;
+    unsigned long hits = 0;
+    bool ok;
     char text[512];
 
+    if (!app_prepare_benchmark_state(&refState, *refCfg)) {
+        return 1;
+    }
+    if (!app_prepare_benchmark_state(&testState, *testCfg)) {
+        app_destroy(&refState);
+        return 1;
+    }
+
+    for (int step = 0; step < cfg->run.benchmarkSteps; step++) {
+        app_script_check_tick(&refState, step, simDt);
+        app_script_check_tick(&testState, step, simDt);
+        kills += (unsigned long)refState.world.tally.kills;
+        hits += (unsigned long)refState.world.tally.hits;
+
+        /* a kill or hit on one side only changes the population, nothing to resync to */
+        tallyField = tally_mismatch(&refState.world.tally, &testState.world.tally, withPairs);
+        if (!tallyField && refState.world.boidCount != testState.world.boidCount) tallyField = "count";
+        if (tallyField) {
+            tallyStep = step;
+            break;
+        }
+
+        for (size_t i = 0; i < refState.world.boidCount; i++) {
+            const Boid a = world_get_boid(&refState.world, i);
+            const Boid b = world_get_boid(&testState.world, i);
+            const float d[4] = {
+                fabsf(a.pos.x - b.pos.x), fabsf(a.pos.y - b.pos.y),
+                fabsf(a.vel.x - b.vel.x), fabsf(a.vel.y - b.vel.y),
+            };
+            for (int k = 0; k < 4; k++) {
+                if (d[k] > maxDiff) {
+                    maxDiff = d[k];
+                    worstStep = step;
+                }
+            }
+            world_set_boid(&testState.world, i, &a);
+        }
+    }
+
+    ok = maxDiff <= tolerance && !tallyField;
     snprintf(text, sizeof(text),
-             "benchmark mode=%s game=%s section=world_update_only threads=%d boids=%d size=%dx%d steps=%d total=%.3f ms avg=%.3f ms/tick ticks=%.2f/s\n",
-             run_mode_name(cfg->mode),
+             "%s game=%s boids=%d size=%dx%d steps=%d kills=%lu hits=%lu max_diff=%g (step %d) tolerance=%g: %s",
+             what,
              game_mode_name(cfg->gameMode),
-             cfg->threadCount,
-             cfg->boidCount,
-             cfg->width,
-             cfg->height,
-             cfg->benchmarkSteps,
-             result->totalMs,
-             result->avgMs,
-             result->ticksPerSecond);
-
-    benchmark_write_text(cfg, text);
+             cfg->run.boidCount,
+             cfg->run.width,
+             cfg->run.height,
+             cfg->run.benchmarkSteps,
+             kills,
+             hits,
+             (double)maxDiff,
+             worstStep,
+             (double)tolerance,
+             ok ? "OK" : "FAILED");
+    bench_write_text(text);
+    if (tallyField) bench_printf(" (%s differs at tick %d)", tallyField, tallyStep);
+    bench_write_text("\n");
+
+    app_destroy(&refState);
+    app_destroy(&testState);
+    return ok ? 0 : 1;
+}
+
+/* the vectorized neighbor loop against the scalar one, both on the grid */
+static int run_kernel_check(const AppConfig* cfg, double simDt) {
+    AppConfig refCfg = *cfg;
+    AppConfig testCfg = *cfg;
+    char what[64];
+
+    refCfg.run.mode = UPDATER_SEQ;
+    refCfg.run.kernel = BOID_KERNEL_SCALAR;
+    testCfg.run.mode = UPDATER_SEQ;
+    snprintf(what, sizeof(what), "kernel check scalar vs %s", boids_kernel_name(cfg->run.kernel));
+    return run_resync_check(what, &refCfg, &testCfg, true, simDt);
 }
 
-static int run_single_benchmark(const AppConfig* cfg, double simDt) {
-    const unsigned benchmarkSeed = 12345u;
-    AppState state;
-    BenchmarkResult result;
+/*
+   The neighbor search against the all-pairs scan it replaced (one grid cell, scalar loop): the
+   --neighbors grid|verlet world with its --kernel has to find the same neighbors. Candidate
+   counts differ by design, all-pairs looks at every boid.
+*/
+static int run_grid_check(const AppConfig* cfg, double simDt) {
+    AppConfig refCfg = *cfg;
+    AppConfig testCfg = *cfg;
+    char what[64];
 
-    if (!app_prepare_benchmark_state(&state, *cfg, benchmarkSeed)) {
-        return 1;
+    if (cfg->run.allPairs) {
+        fprintf(stderr, "--grid-check compares --neighbors grid|verlet against allpairs\n");
+        return 2;
     }
+    refCfg.run.mode = UPDATER_SEQ;
+    refCfg.run.kernel = BOID_KERNEL_SCALAR;
+    refCfg.run.allPairs = true;
+    refCfg.run.verletLists = false;
+    refCfg.run.mortonInterval = 0;
+    testCfg.run.mode = UPDATER_SEQ;
+    snprintf(what, sizeof(what), "grid check allpairs vs %s kernel=%s", cfg->run.verletLists ? "verlet" : "grid",
+             boids_kernel_name(cfg->run.verletLists ? BOID_KERNEL_SCALAR : cfg->run.kernel));
+    return run_resync_check(what, &refCfg, &testCfg, false, simDt);
+}
 
-    result = app_run_benchmark(&state, cfg->benchmarkWarmup, cfg->benchmarkSteps, simDt);
-    print_benchmark_result(cfg, &result);
-    app_destroy(&state);
-    return 0;
+/*
+   First slot where the two worlds differ: a different boid (count, id, flags) or a position /
+   velocity further apart than tolerance. NaN counts as a difference. False if there is none.
+*/
+static bool verify_find_divergence(const World* ref, const World* test, float tolerance, size_t* outBoid, const char** outField, float* outDiff) {
+    const size_t n = ref->boidCount < test->boidCount ? ref->boidCount : test->boidCount;
+    static const char* const fields[4] = {"pos.x", "pos.y", "vel.x", "vel.y"};
+
+    for (size_t i = 0; i < n; i++) {
+        const Boid a = world_get_boid(ref, i);
+        const Boid b = world_get_boid(test, i);
+        const float d[4] = {
+            fabsf(a.pos.x - b.pos.x), fabsf(a.pos.y - b.pos.y),
+            fabsf(a.vel.x - b.vel.x), fabsf(a.vel.y - b.vel.y),
+        };
+
+        *outBoid = i;
+        *outDiff = 0.0f;
+        if (ref->boidId[i] != test->boidId[i]) {
+            *outField = "id";
+            return true;
+        }
+        if (ref->boids.flags[i] != test->boids.flags[i] || a.group != b.group) {
+            *outField = "flags";
+            return true;
+        }
+        for (int k = 0; k < 4; k++) {
+            if (d[k] > tolerance || d[k] != d[k]) {
+                *outField = fields[k];
+                *outDiff = d[k];
+                return true;
+            }
+        }
+    }
+    if (ref->boidCount != test->boidCount) {
+        *outBoid = n;
+        *outField = "count";
+        *outDiff = 0.0f;
+        return true;
+    }
+    return false;
 }
 
-static int run_compare_benchmark(const AppConfig* cfg, double simDt) {
-    const unsigned benchmarkSeed = 12345u;
-    AppConfig seqCfg = *cfg;
-    AppConfig pthreadCfg = *cfg;
-    AppState seqState;
-    AppState pthreadState;
-    BenchmarkResult seqResult;
-    BenchmarkResult pthreadResult;
-    double speedup = 0.0;
-    char text[768];
+/*
+   Determinism check of a parallel backend: a seq and a --mode world start from the same seed
+   and are stepped in lockstep without resyncing, so any difference keeps growing. The state
+   hashes (quantized to the tolerance) are compared after every tick; only on a mismatch are
+   the boids scanned, and the run stops at the first tick with a real divergence. Mismatches
+   that stay within tolerance (a value next to a rounding edge) are just counted. Both worlds
+   play the full game tick with the scripted player (app_script_check_tick), so the kill/hit
+   tally of every tick is compared as well: exact, it decides compaction and the mode rules.
+*/
+static int run_verify(const AppConfig* cfg, double simDt) {
+    const float tolerance = cfg->verifyTolerance > 0.0f ? cfg->verifyTolerance : 0.0f;
+    AppConfig refCfg = *cfg;
+    AppState refState;
+    AppState testState;
+    uint64_t refHash = 0;
+    uint64_t testHash = 0;
+    unsigned long hashOnly = 0;
+    int badStep = -1;
+    size_t badBoid = 0;
+    const char* badField = "";
+    float badDiff = 0.0f;
+    const char* tallyField = NULL;
+    unsigned long kills = 0;
+    unsigned long hits = 0;
+    char text[512];
 
-    seqCfg.mode = RUNMODE_SEQ;
-    seqCfg.threadCount = 1;
-    pthreadCfg.mode = RUNMODE_PTHREAD;
+    if (cfg->run.mode == UPDATER_SEQ) {
+        fprintf(stderr, "--verify compares seq against a parallel backend, use --mode pthread|openmp\n");
+        return 2;
+    }
+    refCfg.run.mode = UPDATER_SEQ;
+    refCfg.run.threadCount = 1;
 
-    if (!app_prepare_benchmark_state(&seqState, seqCfg, benchmarkSeed)) {
+    if (!app_prepare_benchmark_state(&refState, refCfg)) {
         return 1;
     }
-    if (!app_prepare_benchmark_state(&pthreadState, pthreadCfg, benchmarkSeed)) {
-        app_destroy(&seqState);
+    if (!app_prepare_benchmark_state(&testState, *cfg)) {
+        app_destroy(&refState);
         return 1;
     }
 
-    seqResult = app_run_benchmark(&seqState, seqCfg.benchmarkWarmup, seqCfg.benchmarkSteps, simDt);
-    pthreadResult = app_run_benchmark(&pthreadState, pthreadCfg.benchmarkWarmup, pthreadCfg.benchmarkSteps, simDt);
+    for (int step = 0; step < cfg->run.benchmarkSteps; step++) {
+        app_script_check_tick(&refState, step, simDt);
+        app_script_check_tick(&testState, step, simDt);
+        kills += (unsigned long)refState.world.tally.kills;
+        hits += (unsigned long)refState.world.tally.hits;
 
-    if (pthreadResult.avgMs > 0.0) {
-        speedup = seqResult.avgMs / pthreadResult.avgMs;
+        tallyField = tally_mismatch(&refState.world.tally, &testState.world.tally, true);
+        if (tallyField) {
+            badStep = step;
+            break;
+        }
+
+        refHash = world_state_hash(&refState.world, tolerance);
+        testHash = world_state_hash(&testState.world, tolerance);
+        if (refHash == testHash) continue;
+        if (!verify_find_divergence(&refState.world, &testState.world, tolerance, &badBoid, &badField, &badDiff)) {
+            hashOnly++;
+            continue;
+        }
+        badStep = step;
+        break;
     }
 
+    if (badStep < 0) {
         snprintf(text, sizeof(text),
-                 "benchmark compare game=%s section=world_update_only boids=%d size=%dx%d steps=%d\n"
-              "  seq:         avg=%.3f ms/tick | ticks=%.2f/s\n"
-              "  pthread(%d): avg=%.3f ms/tick | ticks=%.2f/s\n"
-              "  speedup:     %.2fx\n",
-              game_mode_name(cfg->gameMode),
-              cfg->boidCount,
-              cfg->width,
-              cfg->height,
-              cfg->benchmarkSteps,
-              seqResult.avgMs,
-              seqResult.ticksPerSecond,
-              pthreadCfg.threadCount,
-              pthreadResult.avgMs,
-              pthreadResult.ticksPerSecond,
-              speedup);
-
-        benchmark_write_text(cfg, text);
-
-    app_destroy(&seqState);
-    app_destroy(&pthreadState);
-    return 0;
+                 "verify seq vs %s threads=%d game=%s kernel=%s boids=%d size=%dx%d steps=%d tolerance=%g: OK hash=%016llx"
+                 " kills=%lu hits=%lu (%lu hash mismatches within tolerance)\n",
+                 updater_kind_name(cfg->run.mode),
+                 cfg->run.threadCount,
+                 game_mode_name(cfg->gameMode),
+                 boids_kernel_name(cfg->run.kernel),
+                 cfg->run.boidCount,
+                 cfg->run.width,
+                 cfg->run.height,
+                 cfg->run.benchmarkSteps,
+                 (double)tolerance,
+                 (unsigned long long)refHash,
+                 kills,
+                 hits,
+                 hashOnly);
+    } else if (tallyField) {
+        const WorldStepTally* r = &refState.world.tally;
+        const WorldStepTally* t = &testState.world.tally;
+        snprintf(text, sizeof(text),
+                 "verify seq vs %s threads=%d game=%s kernel=%s boids=%d size=%dx%d steps=%d tolerance=%g: DIVERGED at tick %d"
+                 " %s kills %lu vs %lu hits %lu vs %lu pairs %llu vs %llu\n",
+                 updater_kind_name(cfg->run.mode),
+                 cfg->run.threadCount,
+                 game_mode_name(cfg->gameMode),
+                 boids_kernel_name(cfg->run.kernel),
+                 cfg->run.boidCount,
+                 cfg->run.width,
+                 cfg->run.height,
+                 cfg->run.benchmarkSteps,
+                 (double)tolerance,
+                 badStep,
+                 tallyField,
+                 (unsigned long)r->kills,
+                 (unsigned long)t->kills,
+                 (unsigned long)r->hits,
+                 (unsigned long)t->hits,
+                 (unsigned long long)r->pairs,
+                 (unsigned long long)t->pairs);
+    } else {
+        snprintf(text, sizeof(text),
+                 "verify seq vs %s threads=%d game=%s kernel=%s boids=%d size=%dx%d steps=%d tolerance=%g: DIVERGED at tick %d"
+                 " boid %lu (id %lu) %s diff=%g hash %016llx vs %016llx\n",
+                 updater_kind_name(cfg->run.mode),
+                 cfg->run.threadCount,
+                 game_mode_name(cfg->gameMode),
+                 boids_kernel_name(cfg->run.kernel),
+                 cfg->run.boidCount,
+                 cfg->run.width,
+                 cfg->run.height,
+                 cfg->run.benchmarkSteps,
+                 (double)tolerance,
+                 badStep,
+                 (unsigned long)badBoid,
+                 badBoid < refState.world.boidCount ? (unsigned long)refState.world.boidId[badBoid] : 0ul,
+                 badField,
+                 (double)badDiff,
+                 (unsigned long long)refHash,
+                 (unsigned long long)testHash);
+    }
+    bench_write_text(text);
+
+    app_destroy(&refState);
+    app_destroy(&testState);
+    return badStep < 0 ? 0 : 1;
 }
 
 static void app_init_live_benchmark(AppState* s) {
@@ -1700,56 +2414,66 @@ static void app_init_live_benchmark(AppState* s) {
     s->liveBenchmark.startUs = time_now_us();
     s->liveBenchmark.lastLogUs = s->liveBenchmark.startUs;
 
-    benchmark_printf(&s->cfg,
-                     "interactive benchmark start game=%s run=%s boids=%d threads=%d\n",
-                     game_mode_name(s->gameMode),
-                     run_mode_name(s->cfg.mode),
-                     s->cfg.boidCount,
-                     s->cfg.threadCount);
-}
-
-static void app_note_live_benchmark_step(AppState* s, double stepMs) {
-    if (!s || !s->liveBenchmark.enabled) return;
-
-    s->liveBenchmark.intervalMsSum += stepMs;
-    s->liveBenchmark.intervalTickCount++;
+    bench_printf("interactive benchmark start game=%s run=%s boids=%d threads=%d\n",
+                 game_mode_name(s->gameMode),
+                 updater_kind_name(s->cfg.run.mode),
+                 s->cfg.run.boidCount,
+                 s->cfg.run.threadCount);
 }
 
-static void app_log_live_benchmark_if_needed(AppState* s) {
+/* render thread: once a second, from the sim counters in the latest snapshot */
+static void app_log_live_benchmark_if_needed(AppState* s, const SimSnapshot* snap) {
     uint64_t nowUs;
     uint64_t intervalUs;
+    uint64_t intervalTicks;
     double totalSec;
     double intervalSec;
     double intervalAvgMs = 0.0;
-    double intervalTicksPerSec = 0.0;
 
-    if (!s || !s->liveBenchmark.enabled) return;
+    if (!s || !s->liveBenchmark.enabled || !snap) return;
 
+    s->liveBenchmark.intervalFrames++;
     nowUs = time_now_us();
     intervalUs = nowUs - s->liveBenchmark.lastLogUs;
     if (intervalUs < 1000000ULL) return;
 
     totalSec = (double)(nowUs - s->liveBenchmark.startUs) / 1000000.0;
     intervalSec = (double)intervalUs / 1000000.0;
-    if (s->liveBenchmark.intervalTickCount > 0) {
-        intervalAvgMs = s->liveBenchmark.intervalMsSum / (double)s->liveBenchmark.intervalTickCount;
-        intervalTicksPerSec = (double)s->liveBenchmark.intervalTickCount / intervalSec;
-    }
-
-    benchmark_printf(&s->cfg,
-                     "[live %.1fs] game=%s run=%s boids=%zu threads=%d interval=%.3f ms/tick overall=%.3f ms/tick ticks=%.2f/s\n",
-                     totalSec,
-                     game_mode_name(s->gameMode),
-                     run_mode_name(s->cfg.mode),
-                     s->world.boidCount,
-                     s->cfg.threadCount,
-                     intervalAvgMs,
-                     s->avgMs,
-                     intervalTicksPerSec);
+    intervalTicks = snap->tick - s->liveBenchmark.lastTick;
+    if (intervalTicks > 0) {
+        intervalAvgMs = (snap->tickMsSum - s->liveBenchmark.lastTickMsSum) / (double)intervalTicks;
+    }
+
+    bench_printf("[live %.1fs] game=%s run=%s boids=%zu threads=%d interval=%.3f ms/tick overall=%.3f ms/tick ticks=%.2f/s frames=%.2f/s\n",
+                 totalSec,
+                 game_mode_name((GameMode)snap->hud.gameMode),
+                 updater_kind_name(s->cfg.run.mode),
+                 snap->boidCount,
+                 s->cfg.run.threadCount,
+                 intervalAvgMs,
+                 snap->avgTickMs,
+                 (double)intervalTicks / intervalSec,
+                 (double)s->liveBenchmark.intervalFrames / intervalSec);
+
+    if (s->profiler) {
+        PhaseTotals now;
+        char sim[512];
+        char draw[512];
+        double simMs;
+        double drawMs;
+
+        profiler_read(s->profiler, &now, true);
+        simMs = profiler_format(&now, &s->liveBenchmark.lastPhases, PROF_SIM_FIRST, PROF_SIM_LAST, sim, sizeof(sim));
+        drawMs = profiler_format(&now, &s->liveBenchmark.lastPhases, PROF_DRAW_FIRST, PROF_DRAW_LAST, draw, sizeof(draw));
+        bench_printf("  sim phases avg/max ms (%.3f per tick): %s\n", simMs, sim);
+        bench_printf("  draw phases avg/max ms (%.3f per frame): %s\n", drawMs, draw);
+        s->liveBenchmark.lastPhases = now;
+    }
 
     s->liveBenchmark.lastLogUs = nowUs;
-    s->liveBenchmark.intervalMsSum = 0.0;
-    s->liveBenchmark.intervalTickCount = 0;
+    s->liveBenchmark.lastTick = snap->tick;
+    s->liveBenchmark.lastTickMsSum = snap->tickMsSum;
+    s->liveBenchmark.intervalFrames = 0;
 }
 
 static void app_finish_live_benchmark(AppState* s) {
@@ -1758,63 +2482,29 @@ static void app_finish_live_benchmark(AppState* s) {
     if (!s || !s->liveBenchmark.enabled) return;
 
     totalSec = (double)(time_now_us() - s->liveBenchmark.startUs) / 1000000.0;
-    benchmark_printf(&s->cfg,
-                     "interactive benchmark end runtime=%.1fs avg=%.3f ms/tick samples=%d log=%s\n",
-                     totalSec,
-                     s->avgMs,
-                     s->avgCount,
-                     benchmark_log_path() ? benchmark_log_path() : "-");
+    bench_printf("interactive benchmark end runtime=%.1fs avg=%.3f ms/tick samples=%d log=%s\n",
+                 totalSec,
+                 s->avgMs,
+                 s->avgCount,
+                 benchmark_log_path() ? benchmark_log_path() : "-");
 }
 
+/* the hit test itself runs inside the step (WorldRules.hitRadius), only the outcome is applied here */
 static void app_apply_survival_rules(AppState* s) {
-    const float hitR = 1.6f;
-    const float hitR2 = hitR * hitR;
-    const float worldW = (float)s->world.width;
-    const float worldH = (float)s->world.height;
-
-    for (size_t i = 0; i < s->world.boidCount; i++) {
-        const Boid* boid = &s->world.boids[i];
-        float dx;
-        float dy;
-        float d2;
-
-        if (!boid->alive || !boid->predator) continue;
-
-        dx = torus_delta_f(boid->pos.x - s->world.player.pos.x, worldW);
-        dy = torus_delta_f(boid->pos.y - s->world.player.pos.y, worldH);
-        d2 = dx * dx + dy * dy;
-        if (d2 < hitR2 && s->playerDamageCooldown <= 0.0) {
-            s->playerHp--;
-            s->playerDamageCooldown = 0.75;
-            if (s->playerHp <= 0) {
-                app_reset_world_for_mode(s);
-            }
-            return;
+    if (s->world.tally.hits > 0 && s->playerDamageCooldown <= 0.0) {
+        s->playerHp--;
+        s->playerDamageCooldown = 0.75;
+        if (s->playerHp <= 0) {
+            app_reset_world_for_mode(s);
         }
     }
 }
 
+/* the step already stored the prey within WorldRules.killRadius as dead */
 static void app_apply_terminate_rules(AppState* s) {
-    const float killR = 1.4f;
-    const float killR2 = killR * killR;
-    const float worldW = (float)s->world.width;
-    const float worldH = (float)s->world.height;
-
-    for (size_t i = 0; i < s->world.boidCount; i++) {
-        Boid* boid = &s->world.boids[i];
-        float dx;
-        float dy;
-        float d2;
-
-        if (!boid->alive || boid->predator) continue;
-
-        dx = torus_delta_f(boid->pos.x - s->world.player.pos.x, worldW);
-        dy = torus_delta_f(boid->pos.y - s->world.player.pos.y, worldH);
-        d2 = dx * dx + dy * dy;
-        if (d2 < killR2) {
-            boid->alive = 0;
-            s->terminateKills++;
-        }
+    if (s->world.tally.kills > 0) {
+        s->terminateKills += (int)s->world.tally.kills;
+        (void)world_compact_dead(&s->world);
     }
 }
 
@@ -1826,84 +2516,242 @@ static void app_apply_mode_rules(AppState* s) {
     }
 }
 
+/* checked by the workers after integrating each boid, see app_apply_mode_rules */
+static void app_update_world_rules(AppState* s) {
+    s->world.rules.killRadius = (s->gameMode == GAMEMODE_TERMINATE44) ? 1.4f : 0.0f;
+    s->world.rules.hitRadius = (s->gameMode == GAMEMODE_SURVIVAL) ? 1.6f : 0.0f;
+}
+
 static void app_step_simulation(AppState* s, double simDt) {
+    PhaseLap lap = profiler_lap_start(s->profiler);
+
     app_update_world_bounds_for_window(s);
+    profiler_lap(&lap, PROF_SIM_BOUNDS);
     app_apply_pending_mode_change(s);
     app_update_player_direction(s);
     world_apply_player_input(&s->world, &s->input, simDt);
+    app_update_world_rules(s);
+    profiler_lap(&lap, PROF_SIM_INPUT);
     app_update_shockwave(s, simDt);
+    profiler_lap(&lap, PROF_SIM_SHOCKWAVE);
+    /* the updater times reorder, grid, step and swap itself */
     app_step_boids(s, simDt);
+    profiler_lap_skip(&lap);
     if (s->playerDamageCooldown > 0.0) s->playerDamageCooldown -= simDt;
     if (s->playerDamageCooldown < 0.0) s->playerDamageCooldown = 0.0;
     if (s->gameMode == GAMEMODE_SURVIVAL) {
         s->survivalTime += simDt;
     }
     app_apply_mode_rules(s);
+    profiler_lap(&lap, PROF_SIM_RULES);
+}
+
+static void app_sim_apply_command(AppState* s, const SimCommand* cmd) {
+    switch (cmd->type) {
+        case SIM_CMD_INPUT:
+            s->input = cmd->u.input;
+            break;
+        case SIM_CMD_SHOCK:
+            s->shockRequest = true;
+            break;
+        case SIM_CMD_MODE:
+            s->pendingMode = (GameMode)cmd->u.mode;
+            s->pendingModeChange = true;
+            break;
+        case SIM_CMD_VIEW:
+            s->viewW = cmd->u.view.w;
+            s->viewH = cmd->u.view.h;
+            break;
+    }
+}
+
+/* sim thread (or the main thread before it starts) */
+static void app_publish_snapshot(AppState* s) {
+    SimSnapshot* snap = snapshot_triple_back(&s->sim->snapshots);
+
+    /* out of memory: the render thread keeps drawing the previous snapshot */
+    if (!sim_snapshot_capture(snap, &s->world)) return;
+
+    snap->hud.gameMode = (int)s->gameMode;
+    snap->hud.playerDir = s->playerDir;
+    snap->hud.shockCooldown = s->shockCooldown;
+    snap->hud.shockTime = s->shockTime;
+    snap->hud.shockRadius = s->shockRadius;
+    snap->hud.terminateKills = s->terminateKills;
+    snap->hud.survivalTime = s->survivalTime;
+    snap->hud.playerHp = s->playerHp;
+    snap->hud.playerMaxHp = s->playerMaxHp;
+    snap->tick = s->simTicks;
+    snap->tickMsSum = s->simMsSum;
+    snap->avgTickMs = s->avgMs;
+    snapshot_triple_publish(&s->sim->snapshots);
+}
+
+static void* app_sim_thread_main(void* arg) {
+    AppState* s = (AppState*)arg;
+    double acc = 0.0;
+    uint64_t lastUs = time_now_us();
+
+    TRACE_THREAD_NAME("sim", 0);
+    while (!atomic_load(&s->sim->stop)) {
+        SimCommand cmd;
+        bool stepped = false;
+
+        while (sim_command_pop(&s->sim->commands, &cmd)) {
+            app_sim_apply_command(s, &cmd);
+        }
+
+        uint64_t nowUs = time_now_us();
+        double frameDt = (double)(nowUs - lastUs) / 1000000.0;
+        lastUs = nowUs;
+        if (frameDt > 0.05) frameDt = 0.05;
+        acc += frameDt;
+
+        while (acc >= s->simDt) {
+            const uint64_t t0 = time_now_us();
+            app_step_simulation(s, s->simDt);
+            const uint64_t t1 = time_now_us();
+            const double ms = (double)(t1 - t0) / 1000.0;
+            s->avgCount++;
+            s->avgMs += (ms - s->avgMs) / (double)s->avgCount;
+            s->simTicks++;
+            s->simMsSum += ms;
+            stepped = true;
+
+            acc -= s->simDt;
+        }
+
+        if (stepped) app_publish_snapshot(s);
+        /* sleep until the next tick is due */
+        time_sleep_us((uint64_t)((s->simDt - acc) * 1000000.0));
+    }
+    return NULL;
+}
+
+/* after the traced threads are joined (the OpenMP pool only sits idle) */
+static void app_finish_trace(const AppConfig* cfg) {
+    if (!cfg->tracePath) return;
+    if (trace_dump(cfg->tracePath)) {
+        printf("trace written to %s\n", cfg->tracePath);
+    } else {
+        fprintf(stderr, "Could not write %s\n", cfg->tracePath);
+    }
+}
+
+static bool app_start_sim_thread(AppState* s) {
+    s->sim = (SimLink*)calloc(1, sizeof(SimLink));
+    if (!s->sim) return false;
+    atomic_init(&s->sim->stop, false);
+    snapshot_triple_init(&s->sim->snapshots);
+    sim_command_queue_init(&s->sim->commands);
+
+    /* the first snapshot is there before the render loop asks for one */
+    app_publish_snapshot(s);
+    if (pthread_create(&s->sim->thread, NULL, app_sim_thread_main, s) != 0) {
+        fprintf(stderr, "Failed to start the simulation thread\n");
+        snapshot_triple_destroy(&s->sim->snapshots);
+        free(s->sim);
+        s->sim = NULL;
+        return false;
+    }
+    return true;
+}
+
+static void app_stop_sim_thread(AppState* s) {
+    if (!s->sim) return;
+    atomic_store(&s->sim->stop, true);
+    pthread_join(s->sim->thread, NULL);
+    snapshot_triple_destroy(&s->sim->snapshots);
+    free(s->sim);
+    s->sim = NULL;
+}
+
+/* render thread: frames drawn and sim ticks per second, refreshed twice a second */
+static void app_update_rates(AppState* s, const SimSnapshot* snap, uint64_t nowUs) {
+    double sec;
+
+    if (!snap) return;
+    s->rateFrames++;
+    if (s->rateStartUs == 0) {
+        s->rateStartUs = nowUs;
+        s->rateTick = snap->tick;
+        s->rateFrames = 0;
+        return;
+    }
+
+    sec = (double)(nowUs - s->rateStartUs) / 1000000.0;
+    if (sec < 0.5) return;
+    s->renderFps = (double)s->rateFrames / sec;
+    s->simTicksPerSec = (double)(snap->tick - s->rateTick) / sec;
+    s->rateStartUs = nowUs;
+    s->rateTick = snap->tick;
+    s->rateFrames = 0;
 }
 
-static void update_window_title(AppState* s) {
-    if (!s || !s->window) return;
+static void update_window_title(AppState* s, const SimSnapshot* snap) {
+    if (!s || !s->window || !snap) return;
     if (++s->titleCounter < 12) return;
     s->titleCounter = 0;
     char title[256];
-    const char* gm = game_mode_name(s->gameMode);
+    const GameMode mode = (GameMode)snap->hud.gameMode;
     char extra[64] = {0};
-    if (s->gameMode == GAMEMODE_TERMINATE44) {
-        snprintf(extra, sizeof(extra), " | kills=%d/44", s->terminateKills);
-    } else if (s->gameMode == GAMEMODE_SURVIVAL) {
+    if (mode == GAMEMODE_TERMINATE44) {
+        snprintf(extra, sizeof(extra), " | kills=%d/44", snap->hud.terminateKills);
+    } else if (mode == GAMEMODE_SURVIVAL) {
         snprintf(extra, sizeof(extra), " | SURVIVE");
     }
 
     snprintf(title, sizeof(title),
-             "Boids=%zu | run=%s | game=%s%s | threads=%d | avg=%.3f ms/tick | 1/2/3 mode | SPACE shock | WASD | Q/ESC quit",
-             s->world.boidCount,
-             run_mode_name(s->cfg.mode),
-             gm,
+             "Boids=%zu | run=%s | game=%s%s | threads=%d | avg=%.3f ms/tick | sim=%.1f ticks/s | fps=%.1f | SPACE shock | WASD | Q/ESC quit",
+             snap->boidCount,
+             updater_kind_name(s->cfg.run.mode),
+             game_mode_name(mode),
              extra,
-             s->cfg.threadCount,
-             s->avgMs);
+             s->cfg.run.threadCount,
+             snap->avgTickMs,
+             s->simTicksPerSec,
+             s->renderFps);
     SDL_SetWindowTitle(s->window, title);
 }
 
 int main(int argc, char** argv) {
     const bool benchmarkExe = exe_name_is_benchmark(argc > 0 ? argv[0] : NULL);
     AppConfig cfg = {
-        .width = 80,
-        .height = 25,
-        .boidCount = 800,
-        .threadCount = 4,
-        .mode = RUNMODE_PTHREAD,
         .gameMode = GAMEMODE_PEACEFUL,
         .benchmarkMode = false,
         .benchmarkCompare = false,
         .liveBenchmarkSession = false,
-        .benchmarkSteps = 0,
-        .benchmarkWarmup = BENCHMARK_WARMUP_STEPS,
+        .kernelCheck = false,
+        .gridCheck = false,
+        .verify = false,
+        .verifyTolerance = 1e-4f,
+        .mortonCompare = false,
+        .verletCompare = false,
+        .syncBench = false,
+        .scheduleCompare = false,
+        .callerCompare = false,
+        .batchCompare = false,
+        .sweep = false,
+        .sweepThreads = {0, 0, 2}, /* 0: 1..online cpus */
+        .sweepBoids = {0, 0, 10},  /* 0: --boids */
+        .tracePath = NULL,
     };
-    const double simDt = 1.0 / 120.0;
+    const double simDt = BENCH_SIM_DT;
 
+    bench_options_init(&cfg.run);
     if (argc <= 1) {
-        cfg.benchmarkSteps = 500;
-        cfg.benchmarkWarmup = BENCHMARK_WARMUP_STEPS;
+        cfg.run.benchmarkSteps = BENCH_DEFAULT_STEPS;
         if (!prompt_startup_config(&cfg, benchmarkExe)) {
             return 0;
         }
     } else {
         for (int i = 1; i < argc; i++) {
+            int used;
+
             if (strcmp(argv[i], "--help") == 0) {
                 print_usage(argv[0]);
                 return 0;
             }
-            if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc) {
-                const char* m = argv[++i];
-                if (strcmp(m, "seq") == 0) cfg.mode = RUNMODE_SEQ;
-                else if (strcmp(m, "pthread") == 0) cfg.mode = RUNMODE_PTHREAD;
-                else {
-                    fprintf(stderr, "Unknown mode: %s\n", m);
-                    return 2;
-                }
-                continue;
-            }
             if (strcmp(argv[i], "--game") == 0 && i + 1 < argc) {
                 if (!parse_game_mode(argv[++i], &cfg.gameMode)) {
                     fprintf(stderr, "Unknown game mode: %s\n", argv[i]);
@@ -1911,20 +2759,78 @@ int main(int argc, char** argv) {
                 }
                 continue;
             }
-            if (strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc) {
+            if (strcmp(argv[i], "--compare") == 0) {
                 cfg.benchmarkMode = true;
-                cfg.benchmarkSteps = parse_int(argv[++i], cfg.benchmarkSteps);
+                cfg.benchmarkCompare = true;
                 continue;
             }
-            if (strcmp(argv[i], "--compare") == 0) {
+            if (strcmp(argv[i], "--morton-compare") == 0) {
                 cfg.benchmarkMode = true;
-                cfg.benchmarkCompare = true;
+                cfg.mortonCompare = true;
+                continue;
+            }
+            if (strcmp(argv[i], "--verlet-compare") == 0) {
+                cfg.benchmarkMode = true;
+                cfg.verletCompare = true;
+                continue;
+            }
+            if (strcmp(argv[i], "--schedule-compare") == 0) {
+                cfg.benchmarkMode = true;
+                cfg.scheduleCompare = true;
                 continue;
             }
-            if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) { cfg.threadCount = parse_int(argv[++i], cfg.threadCount); continue; }
-            if (strcmp(argv[i], "--boids") == 0 && i + 1 < argc) { cfg.boidCount = parse_int(argv[++i], cfg.boidCount); continue; }
-            if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) { cfg.width = parse_int(argv[++i], cfg.width); continue; }
-            if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) { cfg.height = parse_int(argv[++i], cfg.height); continue; }
+            if (strcmp(argv[i], "--caller-compare") == 0) {
+                cfg.benchmarkMode = true;
+                cfg.callerCompare = true;
+                continue;
+            }
+            if (strcmp(argv[i], "--batch-compare") == 0) {
+                cfg.benchmarkMode = true;
+                cfg.batchCompare = true;
+                continue;
+            }
+            if (strcmp(argv[i], "--sync-bench") == 0) {
+                cfg.benchmarkMode = true;
+                cfg.syncBench = true;
+                continue;
+            }
+            if (strcmp(argv[i], "--kernel-check") == 0) {
+                cfg.benchmarkMode = true;
+                cfg.kernelCheck = true;
+                continue;
+            }
+            if (strcmp(argv[i], "--grid-check") == 0) {
+                cfg.benchmarkMode = true;
+                cfg.gridCheck = true;
+                continue;
+            }
+            if (strcmp(argv[i], "--verify") == 0) {
+                cfg.benchmarkMode = true;
+                cfg.verify = true;
+                continue;
+            }
+            if (strcmp(argv[i], "--verify-tol") == 0 && i + 1 < argc) {
+                cfg.verifyTolerance = bench_parse_float(argv[++i], cfg.verifyTolerance);
+                continue;
+            }
+            if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) { cfg.tracePath = argv[++i]; continue; }
+            if (strcmp(argv[i], "--sweep") == 0) {
+                cfg.benchmarkMode = true;
+                cfg.sweep = true;
+                while (i + 1 < argc && strchr(argv[i + 1], '=') != NULL) {
+                    if (!parse_sweep_arg(argv[++i], &cfg)) {
+                        fprintf(stderr, "Bad sweep range: %s (use threads=LO..HI[*F] boids=LO..HI[*F])\n", argv[i]);
+                        return 2;
+                    }
+                }
+                continue;
+            }
+            if (strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc) cfg.benchmarkMode = true;
+
+            /* the world, updater and benchmark flags, parsed like the headless driver parses them */
+            used = bench_options_parse(&cfg.run, argc, argv, &i);
+            if (used < 0) return 2;
+            if (used > 0) continue;
 
             fprintf(stderr, "Unknown arg: %s\n", argv[i]);
             print_usage(argv[0]);
@@ -1932,15 +2838,23 @@ int main(int argc, char** argv) {
         }
     }
 
-    if (cfg.width <= 10 || cfg.height <= 10 || cfg.boidCount <= 0 || cfg.threadCount <= 0) {
-        fprintf(stderr, "Invalid config. Use --help\n");
+    if (!bench_options_finish(&cfg.run)) {
         return 2;
     }
-    if (cfg.benchmarkMode && cfg.benchmarkSteps <= 0) {
+    if (cfg.benchmarkMode && cfg.run.benchmarkSteps <= 0) {
         fprintf(stderr, "Benchmark mode needs a positive step count. Use --benchmark N\n");
         return 2;
     }
-    cfg.benchmarkWarmup = BENCHMARK_WARMUP_STEPS;
+    if (cfg.sweepThreads.lo == 0) {
+        cfg.sweepThreads.lo = 1;
+        cfg.sweepThreads.hi = (int)cpu_online_count();
+    }
+    if (cfg.sweepBoids.lo == 0) cfg.sweepBoids.lo = cfg.sweepBoids.hi = cfg.run.boidCount;
+
+    if (cfg.tracePath && !trace_start(TRACE_SPANS_PER_THREAD)) {
+        fprintf(stderr, "This binary has no tracer, build it with make TRACE_FLAGS=-DBOIDS_TRACE\n");
+        return 2;
+    }
 
     if (cfg.benchmarkMode || cfg.liveBenchmarkSession) {
         benchmark_attach_console();
@@ -1952,27 +2866,45 @@ int main(int argc, char** argv) {
     }
 
     if (cfg.benchmarkMode) {
-        int rc = cfg.benchmarkCompare ? run_compare_benchmark(&cfg, simDt) : run_single_benchmark(&cfg, simDt);
+        int rc;
+        if (cfg.kernelCheck) rc = run_kernel_check(&cfg, simDt);
+        else if (cfg.gridCheck) rc = run_grid_check(&cfg, simDt);
+        else if (cfg.verify) rc = run_verify(&cfg, simDt);
+        else if (cfg.mortonCompare) rc = run_morton_compare_benchmark(&cfg);
+        else if (cfg.verletCompare) rc = run_verlet_compare_benchmark(&cfg);
+        else if (cfg.syncBench) rc = run_sync_benchmark(&cfg);
+        else if (cfg.scheduleCompare) rc = run_schedule_compare_benchmark(&cfg);
+        else if (cfg.sweep) rc = run_sweep_benchmark(&cfg);
+        else if (cfg.callerCompare) rc = run_caller_compare_benchmark(&cfg);
+        else if (cfg.batchCompare) rc = run_batch_compare_benchmark(&cfg);
+        else rc = cfg.benchmarkCompare ? run_compare_benchmark(&cfg) : run_single_benchmark(&cfg);
+        app_finish_trace(&cfg);
         SDL_Quit();
         return rc;
     }
 
+    /*
+       --pin binds part 0 to the thread that builds the updater, this one. The sim thread inherits
+       that mask and runs part 0, so the render thread gets its own affinity back once it started.
+    */
+    CpuAffinity renderAffinity;
+    const bool renderAffinitySaved = cfg.run.pinMode != CPU_PIN_NONE && cpu_affinity_save(&renderAffinity);
+
     if (cfg.liveBenchmarkSession) {
         if (!benchmark_open_log_file()) {
             fprintf(stderr, "Warning: could not open benchmark log file for writing.\n");
         }
-        benchmark_printf(&cfg,
-                         "benchmark launcher config boids=%d threads=%d compare_steps=%d\n",
-                         cfg.boidCount,
-                         cfg.threadCount,
-                         cfg.benchmarkSteps);
+        bench_printf("benchmark launcher config boids=%d threads=%d compare_steps=%d\n",
+                     cfg.run.boidCount,
+                     cfg.run.threadCount,
+                     cfg.run.benchmarkSteps);
         if (benchmark_log_path()) {
-            benchmark_printf(&cfg, "benchmark log file: %s\n", benchmark_log_path());
+            bench_printf("benchmark log file: %s\n", benchmark_log_path());
         }
-        (void)run_compare_benchmark(&cfg, simDt);
+        (void)run_compare_benchmark(&cfg);
     }
 
-    srand((unsigned)time_now_us());
+    if (!cfg.run.seedSet) cfg.run.seed = time_now_us();
 
     AppState st = app_make_initial_state(cfg);
 
@@ -1990,8 +2922,22 @@ int main(int argc, char** argv) {
     }
 
     app_init_live_benchmark(&st);
+    if ((cfg.run.profile || cfg.liveBenchmarkSession) && !app_enable_profiler(&st)) {
+        fprintf(stderr, "Warning: no memory for the phase profiler.\n");
+    }
 
-    double acc = 0.0;
+    st.simDt = simDt;
+    if (!app_start_sim_thread(&st)) {
+        app_destroy(&st);
+        benchmark_close_log_file();
+        SDL_Quit();
+        return 1;
+    }
+    if (renderAffinitySaved && !cpu_affinity_restore(&renderAffinity)) {
+        fprintf(stderr, "Warning: the render thread stays on the cpu of pthread part 0.\n");
+    }
+
+    /* render loop: the simulation runs on its own thread, see app_sim_thread_main */
     uint64_t lastUs = time_now_us();
 
     while (!st.quit) {
@@ -2002,28 +2948,20 @@ int main(int argc, char** argv) {
         double frameDt = (double)(nowUs - lastUs) / 1000000.0;
         lastUs = nowUs;
         if (frameDt > 0.05) frameDt = 0.05;
-        acc += frameDt;
-
-        while (acc >= simDt) {
-            const uint64_t t0 = time_now_us();
-            app_step_simulation(&st, simDt);
-            const uint64_t t1 = time_now_us();
-            const double ms = (double)(t1 - t0) / 1000.0;
-            st.avgCount++;
-            st.avgMs += (ms - st.avgMs) / (double)st.avgCount;
-            app_note_live_benchmark_step(&st, ms);
-
-            acc -= simDt;
-        }
+        st.ui.hpHeartAnimTime += frameDt;
 
-        app_log_live_benchmark_if_needed(&st);
-        update_window_title(&st);
-        draw_world_sdl(&st);
+        const SimSnapshot* snap = snapshot_triple_acquire(&st.sim->snapshots);
+        app_update_rates(&st, snap, nowUs);
+        app_log_live_benchmark_if_needed(&st, snap);
+        update_window_title(&st, snap);
+        draw_world_sdl(&st, snap);
         time_sleep_us(1000);
     }
 
+    app_stop_sim_thread(&st);
     app_finish_live_benchmark(&st);
     app_destroy(&st);
+    app_finish_trace(&cfg);
     benchmark_close_log_file();
     SDL_Quit();
     return 0;
@@ -0,0 +1,144 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* syscall() */
+#endif
+
+#include "perf_counters.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static const char* const g_counterNames[PERF_COUNTER_COUNT] = {
+    [PERF_COUNTER_CYCLES] = "cycles",
+    [PERF_COUNTER_INSTRUCTIONS] = "instructions",
+    [PERF_COUNTER_L1D_MISSES] = "l1d_misses",
+    [PERF_COUNTER_LLC_MISSES] = "llc_misses",
+    [PERF_COUNTER_BRANCH_MISSES] = "branch_misses",
+    [PERF_COUNTER_STALLED_CYCLES] = "stalled_cycles",
+};
+
+const char* perf_counter_name(PerfCounterKind kind) {
+    return kind >= 0 && kind < PERF_COUNTER_COUNT ? g_counterNames[kind] : "unknown";
+}
+
+#ifdef __linux__
+
+static void counter_attr(PerfCounterKind kind, struct perf_event_attr* attr) {
+    memset(attr, 0, sizeof(*attr));
+    attr->size = sizeof(*attr);
+    attr->type = PERF_TYPE_HARDWARE;
+    switch (kind) {
+        case PERF_COUNTER_CYCLES: attr->config = PERF_COUNT_HW_CPU_CYCLES; break;
+        case PERF_COUNTER_INSTRUCTIONS: attr->config = PERF_COUNT_HW_INSTRUCTIONS; break;
+        case PERF_COUNTER_L1D_MISSES:
+            attr->type = PERF_TYPE_HW_CACHE;
+            attr->config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                           (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case PERF_COUNTER_LLC_MISSES: attr->config = PERF_COUNT_HW_CACHE_MISSES; break;
+        case PERF_COUNTER_BRANCH_MISSES: attr->config = PERF_COUNT_HW_BRANCH_MISSES; break;
+        case PERF_COUNTER_STALLED_CYCLES: attr->config = PERF_COUNT_HW_STALLED_CYCLES_BACKEND; break;
+        default: break;
+    }
+    attr->disabled = 1;
+    attr->exclude_kernel = 1;
+    attr->exclude_hv = 1;
+    /* more events than hardware counters are time-shared, the times let us scale back */
+    attr->read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+}
+
+/* pid 0 without inherit: the calling thread only */
+bool perf_counters_open_thread(PerfCounters* pc, unsigned mask) {
+    pc->openCount = 0;
+    pc->firstError = 0;
+    for (int k = 0; k < PERF_COUNTER_COUNT; k++) {
+        struct perf_event_attr attr;
+
+        pc->fd[k] = -1;
+        if (!(mask & PERF_COUNTER_MASK(k))) continue;
+        counter_attr((PerfCounterKind)k, &attr);
+        pc->fd[k] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (pc->fd[k] >= 0) {
+            pc->openCount++;
+        } else if (pc->firstError == 0) {
+            pc->firstError = errno;
+        }
+    }
+    return pc->openCount > 0;
+}
+
+void perf_counters_start(PerfCounters* pc) {
+    for (int k = 0; k < PERF_COUNTER_COUNT; k++) {
+        if (pc->fd[k] < 0) continue;
+        ioctl(pc->fd[k], PERF_EVENT_IOC_RESET, 0);
+        ioctl(pc->fd[k], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void perf_counters_stop(PerfCounters* pc) {
+    for (int k = 0; k < PERF_COUNTER_COUNT; k++) {
+        if (pc->fd[k] >= 0) ioctl(pc->fd[k], PERF_EVENT_IOC_DISABLE, 0);
+    }
+}
+
+void perf_counters_close(PerfCounters* pc, PerfCounterValues* out) {
+    for (int k = 0; k < PERF_COUNTER_COUNT; k++) {
+        uint64_t buf[3]; /* value, time enabled, time running */
+
+        out->valid[k] = false;
+        out->value[k] = 0.0;
+        if (pc->fd[k] < 0) continue;
+        if (read(pc->fd[k], buf, sizeof(buf)) == (ssize_t)sizeof(buf) && buf[2] > 0) {
+            out->valid[k] = true;
+            out->value[k] = buf[2] < buf[1] ? (double)buf[0] * (double)buf[1] / (double)buf[2] : (double)buf[0];
+        }
+        close(pc->fd[k]);
+        pc->fd[k] = -1;
+    }
+}
+
+int perf_event_paranoid_level(void) {
+    FILE* f = fopen("/proc/sys/kernel/perf_event_paranoid", "r");
+    int level = -100;
+
+    if (!f) return level;
+    if (fscanf(f, "%d", &level) != 1) level = -100;
+    fclose(f);
+    return level;
+}
+
+#else
+
+bool perf_counters_open_thread(PerfCounters* pc, unsigned mask) {
+    (void)mask;
+    for (int k = 0; k < PERF_COUNTER_COUNT; k++) pc->fd[k] = -1;
+    pc->openCount = 0;
+    pc->firstError = 0;
+    return false;
+}
+
+void perf_counters_start(PerfCounters* pc) {
+    (void)pc;
+}
+
+void perf_counters_stop(PerfCounters* pc) {
+    (void)pc;
+}
+
+void perf_counters_close(PerfCounters* pc, PerfCounterValues* out) {
+    (void)pc;
+    memset(out, 0, sizeof(*out));
+}
+
+int perf_event_paranoid_level(void) {
+    return -100;
+}
+
+#endif
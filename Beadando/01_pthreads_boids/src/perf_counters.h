@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum PerfCounterKind {
+    PERF_COUNTER_CYCLES = 0,
+    PERF_COUNTER_INSTRUCTIONS,
+    PERF_COUNTER_L1D_MISSES,    /* L1 data read misses */
+    PERF_COUNTER_LLC_MISSES,    /* the generic cache-misses event, last level on most cpus */
+    PERF_COUNTER_BRANCH_MISSES,
+    PERF_COUNTER_STALLED_CYCLES, /* backend stalls, not exposed by every cpu */
+    PERF_COUNTER_COUNT,
+} PerfCounterKind;
+
+#define PERF_COUNTER_MASK(kind) (1u << (kind))
+#define PERF_COUNTER_MASK_ALL ((1u << PERF_COUNTER_COUNT) - 1u)
+
+/*
+   Hardware counters of one thread (Linux perf_event_open, user space only). Each counter is a
+   separate event: the ones the cpu or perf_event_paranoid refuse stay closed and the rest
+   still work. Everywhere else nothing opens.
+*/
+typedef struct PerfCounters {
+    int fd[PERF_COUNTER_COUNT];
+    int openCount;
+    int firstError; /* errno of the first refused counter, 0 if none */
+} PerfCounters;
+
+typedef struct PerfCounterValues {
+    bool valid[PERF_COUNTER_COUNT];
+    double value[PERF_COUNTER_COUNT]; /* scaled up when the kernel multiplexed the counter */
+} PerfCounterValues;
+
+const char* perf_counter_name(PerfCounterKind kind);
+
+/*
+   Opens the counters of mask stopped, counting only the calling thread; false when none of
+   them could be opened. Any thread may start, stop and close them afterwards.
+*/
+bool perf_counters_open_thread(PerfCounters* pc, unsigned mask);
+/* reset + enable, and disable */
+void perf_counters_start(PerfCounters* pc);
+void perf_counters_stop(PerfCounters* pc);
+/* reads and closes; valid[k] is false for counters that did not open or read, openCount stays */
+void perf_counters_close(PerfCounters* pc, PerfCounterValues* out);
+
+/* /proc/sys/kernel/perf_event_paranoid, or a value below -1 when it cannot be read */
+int perf_event_paranoid_level(void);
@@ -0,0 +1,118 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "profiler.h"
+
+#include "trace.h"
+
+#include <stdio.h>
+#include <time.h>
+
+static const char* const g_phaseNames[PROF_PHASE_COUNT] = {
+    [PROF_SIM_BOUNDS] = "bounds",
+    [PROF_SIM_INPUT] = "input",
+    [PROF_SIM_SHOCKWAVE] = "shockwave",
+    [PROF_SIM_REORDER] = "reorder",
+    [PROF_SIM_GRID] = "grid",
+    [PROF_SIM_STEP] = "step",
+    [PROF_SIM_SWAP] = "swap",
+    [PROF_SIM_RULES] = "rules",
+    [PROF_DRAW_CLEAR] = "clear",
+    [PROF_DRAW_DROPDOWN] = "dropdown",
+    [PROF_DRAW_STATS] = "stats",
+    [PROF_DRAW_HEALTH] = "health",
+    [PROF_DRAW_BOIDS] = "boids",
+    [PROF_DRAW_PLAYER] = "player",
+    [PROF_DRAW_RING] = "ring",
+    [PROF_DRAW_ABILITY] = "ability",
+    [PROF_DRAW_PRESENT] = "present",
+};
+
+void profiler_init(PhaseProfiler* p) {
+    for (int i = 0; i < PROF_PHASE_COUNT; i++) {
+        atomic_init(&p->sumNs[i], 0);
+        atomic_init(&p->count[i], 0);
+        atomic_init(&p->maxNs[i], 0);
+    }
+}
+
+const char* profiler_phase_name(ProfPhase phase) {
+    return phase >= 0 && phase < PROF_PHASE_COUNT ? g_phaseNames[phase] : "unknown";
+}
+
+uint64_t profiler_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void profiler_add(PhaseProfiler* p, ProfPhase phase, uint64_t ns) {
+    uint_least64_t max;
+
+    if (!p) return;
+    /* single writer per phase: the add only has to be visible, not ordered */
+    atomic_fetch_add_explicit(&p->sumNs[phase], ns, memory_order_relaxed);
+    atomic_fetch_add_explicit(&p->count[phase], 1, memory_order_relaxed);
+    max = atomic_load_explicit(&p->maxNs[phase], memory_order_relaxed);
+    while (ns > max && !atomic_compare_exchange_weak_explicit(&p->maxNs[phase], &max, ns, memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+/* a tracing build also turns every lap into a trace span, with or without a profiler */
+#ifdef BOIDS_TRACE
+#define LAP_CLOCK_NEEDED(lap) true
+#else
+#define LAP_CLOCK_NEEDED(lap) ((lap)->profiler != NULL)
+#endif
+
+PhaseLap profiler_lap_start(PhaseProfiler* p) {
+    PhaseLap lap = {p, 0};
+    if (LAP_CLOCK_NEEDED(&lap)) lap.t = profiler_now_ns();
+    return lap;
+}
+
+void profiler_lap(PhaseLap* lap, ProfPhase phase) {
+    uint64_t now;
+
+    if (!LAP_CLOCK_NEEDED(lap)) return;
+    now = profiler_now_ns();
+    profiler_add(lap->profiler, phase, now - lap->t);
+    TRACE_SPAN(g_phaseNames[phase], lap->t, now);
+    lap->t = now;
+}
+
+void profiler_lap_skip(PhaseLap* lap) {
+    if (LAP_CLOCK_NEEDED(lap)) lap->t = profiler_now_ns();
+}
+
+void profiler_read(PhaseProfiler* p, PhaseTotals* out, bool takeMax) {
+    for (int i = 0; i < PROF_PHASE_COUNT; i++) {
+        out->sumNs[i] = atomic_load_explicit(&p->sumNs[i], memory_order_relaxed);
+        out->count[i] = atomic_load_explicit(&p->count[i], memory_order_relaxed);
+        out->maxNs[i] = takeMax ? atomic_exchange_explicit(&p->maxNs[i], 0, memory_order_relaxed)
+                                : atomic_load_explicit(&p->maxNs[i], memory_order_relaxed);
+    }
+}
+
+double profiler_format(const PhaseTotals* now, const PhaseTotals* prev, ProfPhase first, ProfPhase last, char* buf, size_t size) {
+    size_t len = 0;
+    double totalMs = 0.0;
+
+    if (size > 0) buf[0] = '\0';
+    for (int i = first; i <= (int)last; i++) {
+        const uint64_t n = now->count[i] - (prev ? prev->count[i] : 0);
+        const uint64_t ns = now->sumNs[i] - (prev ? prev->sumNs[i] : 0);
+        double avgMs;
+        int w;
+
+        if (n == 0) continue;
+        avgMs = (double)ns / (double)n / 1000000.0;
+        totalMs += avgMs;
+        if (len >= size) continue;
+        w = snprintf(buf + len, size - len, "%s%s=%.3f/%.3f", len ? " " : "", g_phaseNames[i], avgMs,
+                     (double)now->maxNs[i] / 1000000.0);
+        if (w > 0) len += (size_t)w;
+    }
+    return totalMs;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+   Named phases of a game tick and of a rendered frame. The updater phases (reorder .. swap)
+   are timed by the backends on the thread that leads the tick; neighbor search, forces and
+   integration run fused in world_step_range, so they share the step phase.
+*/
+typedef enum ProfPhase {
+    PROF_SIM_BOUNDS = 0,
+    PROF_SIM_INPUT,
+    PROF_SIM_SHOCKWAVE,
+    PROF_SIM_REORDER,
+    PROF_SIM_GRID,
+    PROF_SIM_STEP,
+    PROF_SIM_SWAP,
+    PROF_SIM_RULES,
+    PROF_DRAW_CLEAR,
+    PROF_DRAW_DROPDOWN,
+    PROF_DRAW_STATS,
+    PROF_DRAW_HEALTH,
+    PROF_DRAW_BOIDS,
+    PROF_DRAW_PLAYER,
+    PROF_DRAW_RING,
+    PROF_DRAW_ABILITY,
+    PROF_DRAW_PRESENT,
+    PROF_PHASE_COUNT,
+    PROF_SIM_FIRST = PROF_SIM_BOUNDS,
+    PROF_SIM_LAST = PROF_SIM_RULES,
+    PROF_DRAW_FIRST = PROF_DRAW_CLEAR,
+    PROF_DRAW_LAST = PROF_DRAW_PRESENT,
+} ProfPhase;
+
+/*
+   Running totals per phase. Each phase has one writer thread (sim or render), any thread may
+   read; the reader keeps its own previous totals and reports the difference, so nothing is
+   reset under the writer except the interval maximum.
+*/
+typedef struct PhaseProfiler {
+    atomic_uint_least64_t sumNs[PROF_PHASE_COUNT];
+    atomic_uint_least64_t count[PROF_PHASE_COUNT];
+    atomic_uint_least64_t maxNs[PROF_PHASE_COUNT]; /* since the last profiler_read(..., true) */
+} PhaseProfiler;
+
+typedef struct PhaseTotals {
+    uint64_t sumNs[PROF_PHASE_COUNT];
+    uint64_t count[PROF_PHASE_COUNT];
+    uint64_t maxNs[PROF_PHASE_COUNT];
+} PhaseTotals;
+
+/*
+   Lap timer over back-to-back phases: every profiler_lap charges the time since the previous
+   lap to one phase. With a NULL profiler all of it is a no-op that does not read the clock,
+   except in a tracing build (BOIDS_TRACE), where every lap is also a trace span.
+*/
+typedef struct PhaseLap {
+    PhaseProfiler* profiler;
+    uint64_t t;
+} PhaseLap;
+
+void profiler_init(PhaseProfiler* p);
+const char* profiler_phase_name(ProfPhase phase);
+uint64_t profiler_now_ns(void);
+void profiler_add(PhaseProfiler* p, ProfPhase phase, uint64_t ns);
+
+PhaseLap profiler_lap_start(PhaseProfiler* p);
+void profiler_lap(PhaseLap* lap, ProfPhase phase);
+/* restarts the lap without charging anyone, e.g. after a block that times itself */
+void profiler_lap_skip(PhaseLap* lap);
+
+/* takeMax also clears the maxima, so the next read gets the maximum of the new interval */
+void profiler_read(PhaseProfiler* p, PhaseTotals* out, bool takeMax);
+
+/*
+   "name=avg/max" in ms for the phases [first, last] that ran between prev and now (prev may
+   be NULL for the whole run). Returns the summed average of those phases per call, in ms.
+*/
+double profiler_format(const PhaseTotals* now, const PhaseTotals* prev, ProfPhase first, ProfPhase last, char* buf, size_t size);
@@ -0,0 +1,111 @@
+#include "sim_snapshot.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SNAPSHOT_TRIPLE_FRESH 4u
+
+static bool sim_snapshot_reserve(SimSnapshot* snap, size_t count) {
+    size_t cap = snap->capacity ? snap->capacity : 256;
+    void* block;
+    float* f;
+    unsigned char* b;
+
+    if (count <= snap->capacity) return true;
+    while (cap < count) cap *= 2;
+
+    /* the old contents are not kept: every capture overwrites the whole snapshot */
+    block = malloc(cap * (4 * sizeof(float) + 2));
+    if (!block) return false;
+    free(snap->boids.block);
+
+    f = (float*)block;
+    b = (unsigned char*)(f + 4 * cap);
+    snap->boids.block = block;
+    snap->boids.x = f;
+    snap->boids.y = f + cap;
+    snap->boids.vx = f + 2 * cap;
+    snap->boids.vy = f + 3 * cap;
+    snap->boids.group = b;
+    snap->boids.flags = b + cap;
+    snap->capacity = cap;
+    return true;
+}
+
+bool sim_snapshot_capture(SimSnapshot* snap, const World* world) {
+    const size_t n = world->boidCount;
+
+    if (!sim_snapshot_reserve(snap, n)) return false;
+
+    memcpy(snap->boids.x, world->boids.x, n * sizeof(float));
+    memcpy(snap->boids.y, world->boids.y, n * sizeof(float));
+    memcpy(snap->boids.vx, world->boids.vx, n * sizeof(float));
+    memcpy(snap->boids.vy, world->boids.vy, n * sizeof(float));
+    memcpy(snap->boids.group, world->boids.group, n);
+    memcpy(snap->boids.flags, world->boids.flags, n);
+    snap->boidCount = n;
+    snap->width = world->width;
+    snap->height = world->height;
+    snap->groupCount = world->groupCount;
+    snap->player = world->player;
+    return true;
+}
+
+void snapshot_triple_init(SnapshotTriple* t) {
+    memset(t->slots, 0, sizeof(t->slots));
+    t->back = 0;
+    atomic_init(&t->middle, 1u);
+    t->front = 2;
+    t->hasFront = false;
+}
+
+void snapshot_triple_destroy(SnapshotTriple* t) {
+    for (int i = 0; i < 3; i++) {
+        free(t->slots[i].boids.block);
+        memset(&t->slots[i], 0, sizeof(t->slots[i]));
+    }
+}
+
+SimSnapshot* snapshot_triple_back(SnapshotTriple* t) {
+    return &t->slots[t->back];
+}
+
+void snapshot_triple_publish(SnapshotTriple* t) {
+    /* release: the slot contents are visible before the reader can take the index */
+    unsigned prev = atomic_exchange_explicit(&t->middle, t->back | SNAPSHOT_TRIPLE_FRESH, memory_order_acq_rel);
+    t->back = prev & 3u;
+}
+
+const SimSnapshot* snapshot_triple_acquire(SnapshotTriple* t) {
+    if (atomic_load_explicit(&t->middle, memory_order_acquire) & SNAPSHOT_TRIPLE_FRESH) {
+        unsigned prev = atomic_exchange_explicit(&t->middle, t->front, memory_order_acq_rel);
+        t->front = prev & 3u;
+        t->hasFront = true;
+    }
+    return t->hasFront ? &t->slots[t->front] : NULL;
+}
+
+void sim_command_queue_init(SimCommandQueue* q) {
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+}
+
+bool sim_command_push(SimCommandQueue* q, const SimCommand* cmd) {
+    const size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    const size_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+
+    if (tail - head >= SIM_COMMAND_CAPACITY) return false;
+    q->items[tail & (SIM_COMMAND_CAPACITY - 1)] = *cmd;
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+bool sim_command_pop(SimCommandQueue* q, SimCommand* out) {
+    const size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    const size_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+
+    if (head == tail) return false;
+    *out = q->items[head & (SIM_COMMAND_CAPACITY - 1)];
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    return true;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "boids.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* game state the HUD shows, copied next to the boids */
+typedef struct SimHud {
+    int gameMode;
+    Vec2 playerDir;
+    double shockCooldown;
+    double shockTime;
+    float shockRadius;
+    int terminateKills;
+    double survivalTime;
+    int playerHp;
+    int playerMaxHp;
+} SimHud;
+
+/*
+   Immutable copy of one simulation tick for the render thread: the live slots [0, boidCount)
+   of World.boids, the player, the HUD and the running tick counters of the sim thread.
+*/
+typedef struct SimSnapshot {
+    size_t boidCount;
+    size_t capacity;
+    BoidArrays boids;
+    int width;
+    int height;
+    int groupCount;
+    Player player;
+    SimHud hud;
+    uint64_t tick;    /* ticks simulated so far */
+    double tickMsSum; /* their summed step time */
+    double avgTickMs;
+} SimSnapshot;
+
+/* Copies the boids and the world geometry, growing the arrays if needed. Returns false on OOM. */
+bool sim_snapshot_capture(SimSnapshot* snap, const World* world);
+
+/*
+   Lock-free triple buffer between one writer (sim thread) and one reader (render thread).
+   The writer fills its back slot and swaps it with the middle one, the reader swaps its front
+   slot with the middle one when that holds a newer snapshot. Neither side ever waits, the
+   reader always sees the most recent complete snapshot and never a half-written one.
+*/
+typedef struct SnapshotTriple {
+    SimSnapshot slots[3];
+    atomic_uint middle; /* slot index | SNAPSHOT_TRIPLE_FRESH */
+    unsigned back;      /* writer only */
+    unsigned front;     /* reader only */
+    bool hasFront;      /* reader only: false until the first publish was picked up */
+} SnapshotTriple;
+
+void snapshot_triple_init(SnapshotTriple* t);
+void snapshot_triple_destroy(SnapshotTriple* t);
+
+/* writer: the slot to fill, then publish it */
+SimSnapshot* snapshot_triple_back(SnapshotTriple* t);
+void snapshot_triple_publish(SnapshotTriple* t);
+
+/* reader: the latest published snapshot (NULL before the first publish), valid until the next call */
+const SimSnapshot* snapshot_triple_acquire(SnapshotTriple* t);
+
+typedef enum SimCommandType {
+    SIM_CMD_INPUT = 0, /* movement keys held */
+    SIM_CMD_SHOCK,     /* shockwave requested */
+    SIM_CMD_MODE,      /* switch game mode (resets the world) */
+    SIM_CMD_VIEW,      /* window size in pixels, the world bounds follow it */
+} SimCommandType;
+
+typedef struct SimCommand {
+    SimCommandType type;
+    union {
+        InputState input;
+        int mode;
+        struct {
+            int w;
+            int h;
+        } view;
+    } u;
+} SimCommand;
+
+enum {
+    SIM_COMMAND_CAPACITY = 256, /* power of two */
+};
+
+/* Bounded single-producer single-consumer ring from the render thread to the sim thread. */
+typedef struct SimCommandQueue {
+    SimCommand items[SIM_COMMAND_CAPACITY];
+    atomic_size_t head; /* next slot to pop, written by the consumer */
+    atomic_size_t tail; /* next slot to push, written by the producer */
+} SimCommandQueue;
+
+void sim_command_queue_init(SimCommandQueue* q);
+/* false if the queue is full (the command is dropped) */
+bool sim_command_push(SimCommandQueue* q, const SimCommand* cmd);
+/* false if the queue is empty */
+bool sim_command_pop(SimCommandQueue* q, SimCommand* out);
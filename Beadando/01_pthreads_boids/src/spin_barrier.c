@@ -0,0 +1,63 @@
+#include "spin_barrier.h"
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+bool spin_barrier_init(SpinBarrier* b, size_t count, unsigned spinLimit) {
+    if (count == 0) return false;
+    b->count = count;
+    atomic_init(&b->arrived, 0);
+    atomic_init(&b->sense, 0);
+    atomic_init(&b->sleepers, 0);
+    atomic_init(&b->spinLimit, spinLimit);
+    if (pthread_mutex_init(&b->m, NULL) != 0) return false;
+    if (pthread_cond_init(&b->cv, NULL) != 0) {
+        pthread_mutex_destroy(&b->m);
+        return false;
+    }
+    return true;
+}
+
+void spin_barrier_destroy(SpinBarrier* b) {
+    pthread_mutex_destroy(&b->m);
+    pthread_cond_destroy(&b->cv);
+}
+
+void spin_barrier_set_spin(SpinBarrier* b, unsigned spinLimit) {
+    atomic_store_explicit(&b->spinLimit, spinLimit, memory_order_relaxed);
+}
+
+void spin_barrier_wait(SpinBarrier* b, unsigned* localSense) {
+    const unsigned sense = *localSense ^ 1u;
+    *localSense = sense;
+
+    if (atomic_fetch_add_explicit(&b->arrived, 1, memory_order_acq_rel) + 1 == b->count) {
+        /* last one in: reset the counter before anybody can enter the next round */
+        atomic_store_explicit(&b->arrived, 0, memory_order_relaxed);
+        atomic_store(&b->sense, sense);
+        /* a sleeper registers before its final check, so either it sees the new sense or we see it */
+        if (atomic_load(&b->sleepers) > 0) {
+            pthread_mutex_lock(&b->m);
+            pthread_cond_broadcast(&b->cv);
+            pthread_mutex_unlock(&b->m);
+        }
+        return;
+    }
+
+    const unsigned spinLimit = atomic_load_explicit(&b->spinLimit, memory_order_relaxed);
+    for (unsigned i = 0; i < spinLimit; i++) {
+        if (atomic_load_explicit(&b->sense, memory_order_acquire) == sense) return;
+        cpu_relax();
+    }
+
+    pthread_mutex_lock(&b->m);
+    atomic_fetch_add(&b->sleepers, 1);
+    while (atomic_load(&b->sense) != sense) {
+        pthread_cond_wait(&b->cv, &b->m);
+    }
+    atomic_fetch_sub(&b->sleepers, 1);
+    pthread_mutex_unlock(&b->m);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+   Sense-reversing barrier for a fixed number of threads. A waiter spins on the shared sense
+   for up to spinLimit rounds, then sleeps on the condition variable, so short waits stay
+   out of the kernel and long waits do not burn a core.
+*/
+typedef struct SpinBarrier {
+    size_t count;
+    atomic_size_t arrived;
+    atomic_uint sense;
+    atomic_uint sleepers;
+    atomic_uint spinLimit;
+
+    pthread_mutex_t m;
+    pthread_cond_t cv;
+} SpinBarrier;
+
+enum {
+    SPIN_BARRIER_DEFAULT_SPIN = 4000,
+};
+
+bool spin_barrier_init(SpinBarrier* b, size_t count, unsigned spinLimit);
+void spin_barrier_destroy(SpinBarrier* b);
+/* 0 = block right away; may be changed while threads are waiting */
+void spin_barrier_set_spin(SpinBarrier* b, unsigned spinLimit);
+
+/* localSense is per-thread state, start it at 0 */
+void spin_barrier_wait(SpinBarrier* b, unsigned* localSense);
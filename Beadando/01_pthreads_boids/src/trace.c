@@ -0,0 +1,142 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "trace.h"
+
+#ifdef BOIDS_TRACE
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+enum {
+    TRACE_MAX_THREADS = 512,
+};
+
+typedef struct TraceSpan {
+    const char* name;
+    uint64_t beginNs;
+    uint64_t endNs;
+} TraceSpan;
+
+/* written only by its own thread; the dump reads it once the writers are done */
+typedef struct TraceRing {
+    TraceSpan* spans;
+    size_t capacity;
+    size_t written; /* total, the ring holds the last min(written, capacity) */
+    const char* threadName;
+    size_t threadIndex;
+} TraceRing;
+
+static atomic_bool g_traceOn = false;
+static size_t g_ringCapacity;
+static uint64_t g_traceBaseNs;
+static TraceRing* g_rings[TRACE_MAX_THREADS];
+static atomic_int g_ringCount = 0;
+static _Thread_local TraceRing* t_ring = NULL;
+
+uint64_t trace_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* the calling thread's ring, created on its first span; NULL when off or out of slots */
+static TraceRing* trace_ring(void) {
+    TraceRing* ring;
+    int slot;
+
+    if (t_ring) return t_ring;
+    if (!atomic_load_explicit(&g_traceOn, memory_order_acquire)) return NULL;
+
+    slot = atomic_fetch_add(&g_ringCount, 1);
+    if (slot >= TRACE_MAX_THREADS) return NULL;
+    ring = (TraceRing*)calloc(1, sizeof(TraceRing));
+    if (ring) ring->spans = (TraceSpan*)malloc(g_ringCapacity * sizeof(TraceSpan));
+    if (!ring || !ring->spans) {
+        free(ring);
+        return NULL;
+    }
+    ring->capacity = g_ringCapacity;
+    ring->threadIndex = (size_t)slot;
+    g_rings[slot] = ring;
+    t_ring = ring;
+    return ring;
+}
+
+void trace_span(const char* name, uint64_t beginNs, uint64_t endNs) {
+    TraceRing* ring = trace_ring();
+    TraceSpan* s;
+
+    if (!ring) return;
+    s = &ring->spans[ring->written % ring->capacity];
+    s->name = name;
+    s->beginNs = beginNs;
+    s->endNs = endNs;
+    ring->written++;
+}
+
+void trace_thread_name(const char* name, size_t index) {
+    TraceRing* ring = trace_ring();
+
+    if (!ring) return;
+    ring->threadName = name;
+    ring->threadIndex = index;
+}
+
+bool trace_start(size_t spansPerThread) {
+    g_ringCapacity = spansPerThread > 0 ? spansPerThread : 1;
+    g_traceBaseNs = trace_now_ns();
+    atomic_store_explicit(&g_traceOn, true, memory_order_release);
+    trace_thread_name("main", 0);
+    return true;
+}
+
+bool trace_dump(const char* path) {
+    const int count = atomic_load(&g_ringCount) < TRACE_MAX_THREADS ? atomic_load(&g_ringCount) : TRACE_MAX_THREADS;
+    FILE* f;
+    bool first = true;
+
+    atomic_store_explicit(&g_traceOn, false, memory_order_release);
+    f = fopen(path, "w");
+    if (!f) return false;
+
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", f);
+    for (int r = 0; r < count; r++) {
+        const TraceRing* ring = g_rings[r];
+        const size_t kept = ring && ring->written < ring->capacity ? ring->written : (ring ? ring->capacity : 0);
+
+        if (!ring) continue;
+        if (ring->threadName) {
+            fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s %zu\"}}",
+                    first ? "" : ",\n", r, ring->threadName, ring->threadIndex);
+            first = false;
+        }
+        for (size_t i = ring->written - kept; i < ring->written; i++) {
+            const TraceSpan* s = &ring->spans[i % ring->capacity];
+            /* ts and dur are in microseconds */
+            fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    first ? "" : ",\n", s->name, r, (double)(s->beginNs - g_traceBaseNs) / 1000.0,
+                    (double)(s->endNs - s->beginNs) / 1000.0);
+            first = false;
+        }
+    }
+    fputs("\n]}\n", f);
+    return fclose(f) == 0;
+}
+
+#else
+
+bool trace_start(size_t spansPerThread) {
+    (void)spansPerThread;
+    return false;
+}
+
+bool trace_dump(const char* path) {
+    (void)path;
+    return false;
+}
+
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+   Span tracer for the Chrome trace_event format (chrome://tracing, ui.perfetto.dev). Every
+   thread writes complete spans (name, begin, end) into a ring of its own, the oldest spans
+   are overwritten when it is full. Only built with -DBOIDS_TRACE (make TRACE_FLAGS=-DBOIDS_TRACE);
+   otherwise the TRACE_* macros compile to nothing and trace_start reports that it is missing.
+*/
+
+/* false when the build has no tracer or the registry cannot be allocated */
+bool trace_start(size_t spansPerThread);
+/* call after the traced threads finished (or sit idle); stops recording */
+bool trace_dump(const char* path);
+
+#ifdef BOIDS_TRACE
+
+uint64_t trace_now_ns(void);
+/* span names must be string literals (or live as long as the trace) */
+void trace_span(const char* name, uint64_t beginNs, uint64_t endNs);
+void trace_thread_name(const char* name, size_t index);
+
+#define TRACE_BEGIN(var) uint64_t var = trace_now_ns()
+#define TRACE_END(var, name) trace_span((name), (var), trace_now_ns())
+/* a span from timestamps the caller already takes for its own accounting */
+#define TRACE_SPAN(name, beginNs, endNs) trace_span((name), (beginNs), (endNs))
+#define TRACE_THREAD_NAME(name, index) trace_thread_name((name), (index))
+
+#else
+
+#define TRACE_BEGIN(var) ((void)0)
+#define TRACE_END(var, name) ((void)0)
+#define TRACE_SPAN(name, beginNs, endNs) ((void)0)
+#define TRACE_THREAD_NAME(name, index) ((void)0)
+
+#endif
@@ -0,0 +1,167 @@
+#include "update_openmp.h"
+
+#include "profiler.h"
+
+#include <stdlib.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+bool update_openmp_available(void) {
+#ifdef _OPENMP
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool update_openmp_init(UpdateOpenmp* u, size_t threadCount) {
+    if (!u || threadCount == 0 || !update_openmp_available()) return false;
+
+    u->threadCount = threadCount;
+    u->schedule = UPDATE_SCHEDULE_CHUNKED;
+    u->chunkSize = UPDATE_DEFAULT_CHUNK;
+    u->wallSec = 0.0;
+    u->bounds = (size_t*)calloc(threadCount + 1, sizeof(size_t));
+    u->busySec = (double*)calloc(threadCount, sizeof(double));
+    if (!u->bounds || !u->busySec) {
+        free(u->bounds);
+        free(u->busySec);
+        u->bounds = NULL;
+        u->busySec = NULL;
+        return false;
+    }
+    return true;
+}
+
+void update_openmp_destroy(UpdateOpenmp* u) {
+    if (!u) return;
+    free(u->bounds);
+    free(u->busySec);
+    u->bounds = NULL;
+    u->busySec = NULL;
+    u->threadCount = 0;
+}
+
+void update_openmp_set_schedule(UpdateOpenmp* u, UpdateSchedule schedule, size_t chunkSize) {
+    if (!u) return;
+    u->schedule = schedule;
+    u->chunkSize = chunkSize > 0 ? chunkSize : UPDATE_DEFAULT_CHUNK;
+}
+
+#ifdef _OPENMP
+
+/* one iteration per part, so every part runs even if the runtime hands out fewer threads */
+static void openmp_run(void* ctx, WorldPartFn fn, void* arg) {
+    UpdateOpenmp* u = (UpdateOpenmp*)ctx;
+    const long parts = (long)u->threadCount;
+    const double t0 = omp_get_wtime();
+
+#pragma omp parallel for schedule(static, 1) num_threads((int)u->threadCount)
+    for (long p = 0; p < parts; p++) {
+        const double t1 = omp_get_wtime();
+        fn(arg, (size_t)p, (size_t)parts);
+        u->busySec[omp_get_thread_num()] += omp_get_wtime() - t1;
+    }
+
+    u->wallSec += omp_get_wtime() - t0;
+}
+
+/* the step of update_pthreads_step's schedules; the tallies are integer sums, so any order gives the same total */
+static void openmp_step_boids(UpdateOpenmp* u, World* w, double dt) {
+    const size_t n = w->boidCount;
+    const double t0 = omp_get_wtime();
+    size_t kills = 0;
+    size_t hits = 0;
+    uint64_t pairs = 0;
+
+    if (u->schedule == UPDATE_SCHEDULE_CHUNKED) {
+        const long chunks = (long)((n + u->chunkSize - 1) / u->chunkSize);
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads((int)u->threadCount) reduction(+ : kills, hits, pairs)
+        for (long c = 0; c < chunks; c++) {
+            const double t1 = omp_get_wtime();
+            const size_t begin = (size_t)c * u->chunkSize;
+            const size_t end = begin + u->chunkSize < n ? begin + u->chunkSize : n;
+            WorldStepTally tally = {0, 0, 0};
+            world_step_range(w, w, begin, end, dt, &tally);
+            kills += tally.kills;
+            hits += tally.hits;
+            pairs += tally.pairs;
+            u->busySec[omp_get_thread_num()] += omp_get_wtime() - t1;
+        }
+    } else {
+        const long parts = (long)u->threadCount;
+        const bool cost = u->schedule == UPDATE_SCHEDULE_COST;
+
+        if (cost) world_cost_partition(w, u->threadCount, u->bounds);
+
+#pragma omp parallel for schedule(static, 1) num_threads((int)u->threadCount) reduction(+ : kills, hits, pairs)
+        for (long p = 0; p < parts; p++) {
+            const double t1 = omp_get_wtime();
+            const size_t begin = cost ? u->bounds[p] : (n * (size_t)p) / (size_t)parts;
+            const size_t end = cost ? u->bounds[p + 1] : (n * (size_t)(p + 1)) / (size_t)parts;
+            WorldStepTally tally = {0, 0, 0};
+            world_step_range(w, w, begin, end, dt, &tally);
+            kills += tally.kills;
+            hits += tally.hits;
+            pairs += tally.pairs;
+            u->busySec[omp_get_thread_num()] += omp_get_wtime() - t1;
+        }
+    }
+
+    u->wallSec += omp_get_wtime() - t0;
+    w->tally.kills = kills;
+    w->tally.hits = hits;
+    w->tally.pairs = pairs;
+    w->stepPairs += pairs;
+}
+
+#else
+
+static void openmp_run(void* ctx, WorldPartFn fn, void* arg) {
+    UpdateOpenmp* u = (UpdateOpenmp*)ctx;
+    for (size_t p = 0; p < u->threadCount; p++) fn(arg, p, u->threadCount);
+}
+
+static void openmp_step_boids(UpdateOpenmp* u, World* w, double dt) {
+    (void)u;
+    w->tally = (WorldStepTally){0, 0, 0};
+    world_step_range(w, w, 0, w->boidCount, dt, &w->tally);
+    w->stepPairs += w->tally.pairs;
+}
+
+#endif
+
+void update_openmp_step(UpdateOpenmp* u, World* w, double dt) {
+    WorldParallel par = update_openmp_parallel(u);
+    PhaseLap lap = profiler_lap_start(w->profiler);
+
+    world_reorder_if_due(w, &par);
+    profiler_lap(&lap, PROF_SIM_REORDER);
+    world_prepare_step(w, &par);
+    profiler_lap(&lap, PROF_SIM_GRID);
+    openmp_step_boids(u, w, dt);
+    profiler_lap(&lap, PROF_SIM_STEP);
+    world_swap_buffers(w);
+    profiler_lap(&lap, PROF_SIM_SWAP);
+}
+
+void update_openmp_reset_stats(UpdateOpenmp* u) {
+    if (!u || !u->busySec) return;
+    u->wallSec = 0.0;
+    for (size_t i = 0; i < u->threadCount; i++) u->busySec[i] = 0.0;
+}
+
+bool update_openmp_thread_stats(const UpdateOpenmp* u, size_t thread, UpdateThreadStats* out) {
+    if (!u || !u->busySec || !out || thread >= u->threadCount) return false;
+    out->busyMs = u->busySec[thread] * 1000.0;
+    out->idleMs = u->wallSec > u->busySec[thread] ? (u->wallSec - u->busySec[thread]) * 1000.0 : 0.0;
+    return true;
+}
+
+WorldParallel update_openmp_parallel(UpdateOpenmp* u) {
+    WorldParallel par = {openmp_run, u, u->threadCount};
+    return par;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "boids.h"
+#include "update_pthreads.h" /* UpdateSchedule, UpdateThreadStats */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+   OpenMP counterpart of UpdatePthreads: the same tick (re-sort, prepare, step, tally, swap)
+   with the parallel passes in omp parallel regions of threadCount threads. Without -fopenmp
+   it still compiles, but init fails.
+*/
+typedef struct UpdateOpenmp {
+    size_t threadCount;
+    UpdateSchedule schedule;
+    size_t chunkSize;
+    size_t* bounds;   /* threadCount + 1 slice bounds of the cost schedule */
+    double* busySec;  /* per omp thread, inside parallel work */
+    double wallSec;
+} UpdateOpenmp;
+
+bool update_openmp_available(void);
+bool update_openmp_init(UpdateOpenmp* updater, size_t threadCount);
+void update_openmp_destroy(UpdateOpenmp* updater);
+void update_openmp_set_schedule(UpdateOpenmp* updater, UpdateSchedule schedule, size_t chunkSize);
+/* one tick, fills world->tally like update_pthreads_step */
+void update_openmp_step(UpdateOpenmp* updater, World* world, double dt);
+
+void update_openmp_reset_stats(UpdateOpenmp* updater);
+bool update_openmp_thread_stats(const UpdateOpenmp* updater, size_t thread, UpdateThreadStats* out);
+
+/* WorldParallel over omp threads, valid while the updater lives */
+WorldParallel update_openmp_parallel(UpdateOpenmp* updater);
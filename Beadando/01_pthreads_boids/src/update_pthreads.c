@@ -1,102 +1,145 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "update_pthreads.h"
 
+#include "cpu_affinity.h"
+#include "profiler.h"
+#include "spin_barrier.h"
+#include "trace.h"
+
 #include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <time.h>
 
 typedef struct WorkerCtx {
     size_t id;
     struct Impl* impl;
+    uint64_t busyNs;
+    uint64_t teamWaitNs; /* part of busyNs spent at the team barrier of update_pthreads_run */
+    unsigned teamSense;
 } WorkerCtx;
 
 typedef struct Impl {
-    size_t threadCount;
+    size_t threadCount; /* parts per run, including the caller when it works */
+    size_t workerCount; /* started threads */
+    bool callerWorks;   /* the caller runs part 0 itself, the workers run the rest */
     pthread_t* threads;
-    WorkerCtx* ctx;
+    WorkerCtx* ctx;     /* one per part */
 
-    pthread_mutex_t m;
-    pthread_cond_t cvStart;
-    pthread_cond_t cvDone;
+    /* workers + the calling thread meet here twice per run: once to start, once when done */
+    SpinBarrier barrier;
+    unsigned callerSense;
+    /* the parts alone (no waiting caller) meet here between the phases of update_pthreads_run */
+    SpinBarrier team;
+    pthread_mutex_t startGate; /* held while the workers are created, so none touches the barrier early */
 
-    const World* worldRead;
-    World* worldWrite;
-    double dt;
-    size_t finished;
-    bool hasWork;
+    WorldPartFn fn;
+    void* arg;
     bool stop;
+
+    UpdateSchedule schedule;
+    size_t chunkSize;
+    size_t* bounds; /* threadCount + 1 slice bounds of the cost schedule */
+    WorldStepTally* tallies; /* rule catches of each part, summed in part order after the step */
+    uint64_t wallNs; /* summed duration of the runs, as seen by the caller */
 } Impl;
 
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void impl_free(Impl* impl) {
+    free(impl->threads);
+    free(impl->ctx);
+    free(impl->bounds);
+    free(impl->tallies);
+    free(impl);
+}
 
 static void* worker_main(void* p) {
     WorkerCtx* ctx = (WorkerCtx*)p;
     Impl* impl = ctx->impl;
+    unsigned sense = 0;
 
-    while (true) {
-        pthread_mutex_lock(&impl->m);
-        while (!impl->hasWork && !impl->stop) {
-            pthread_cond_wait(&impl->cvStart, &impl->m);
-        }
-        if (impl->stop) {
-            pthread_mutex_unlock(&impl->m);
-            break;
-        }
+    pthread_mutex_lock(&impl->startGate);
+    pthread_mutex_unlock(&impl->startGate);
+    TRACE_THREAD_NAME("worker", ctx->id);
 
-        const World* r = impl->worldRead;
-        World* w = impl->worldWrite;
-        double dt = impl->dt;
-        size_t tc = impl->threadCount;
-        size_t id = ctx->id;
-        pthread_mutex_unlock(&impl->m);
-
-        size_t begin = (r->boidCount * id) / tc;
-        size_t end = (r->boidCount * (id + 1)) / tc;
+    while (true) {
+        /* fn, arg and stop are written before the start barrier and read after it */
+        TRACE_BEGIN(wake);
+        spin_barrier_wait(&impl->barrier, &sense);
+        TRACE_END(wake, "wait_work");
+        if (impl->stop) break;
 
-        world_step_range(r, w, begin, end, dt);
+        uint64_t t0 = now_ns();
+        impl->fn(impl->arg, ctx->id, impl->threadCount);
+        uint64_t t1 = now_ns();
+        ctx->busyNs += t1 - t0;
+        TRACE_SPAN("part", t0, t1);
 
-        pthread_mutex_lock(&impl->m);
-        impl->finished++;
-        if (impl->finished == impl->threadCount) {
-            impl->hasWork = false;
-            pthread_cond_signal(&impl->cvDone);
-        }
-        pthread_mutex_unlock(&impl->m);
+        TRACE_BEGIN(join);
+        spin_barrier_wait(&impl->barrier, &sense);
+        TRACE_END(join, "join");
     }
 
     return NULL;
 }
 
-bool update_pthreads_init(UpdatePthreads* u, size_t threadCount) {
+bool update_pthreads_init(UpdatePthreads* u, size_t threadCount, bool callerWorks) {
+    if (threadCount == 0) return false;
     Impl* impl = (Impl*)calloc(1, sizeof(Impl));
     if (!impl) return false;
 
     impl->threadCount = threadCount;
-    impl->threads = (pthread_t*)calloc(threadCount, sizeof(pthread_t));
+    impl->callerWorks = callerWorks;
+    impl->workerCount = callerWorks ? threadCount - 1 : threadCount;
+    impl->schedule = UPDATE_SCHEDULE_CHUNKED;
+    impl->chunkSize = UPDATE_DEFAULT_CHUNK;
+    impl->threads = (pthread_t*)calloc(impl->workerCount ? impl->workerCount : 1, sizeof(pthread_t));
     impl->ctx = (WorkerCtx*)calloc(threadCount, sizeof(WorkerCtx));
-    if (!impl->threads || !impl->ctx) {
-        free(impl->threads);
-        free(impl->ctx);
-        free(impl);
+    impl->bounds = (size_t*)calloc(threadCount + 1, sizeof(size_t));
+    impl->tallies = (WorldStepTally*)calloc(threadCount, sizeof(WorldStepTally));
+    /* spinning only pays off when every participant has a core of its own */
+    const unsigned spin = cpu_online_count() > impl->workerCount ? SPIN_BARRIER_DEFAULT_SPIN : 0;
+    const unsigned teamSpin = cpu_online_count() >= threadCount ? SPIN_BARRIER_DEFAULT_SPIN : 0;
+    if (!impl->threads || !impl->ctx || !impl->bounds || !impl->tallies || !spin_barrier_init(&impl->barrier, impl->workerCount + 1, spin)) {
+        impl_free(impl);
+        return false;
+    }
+    if (!spin_barrier_init(&impl->team, threadCount, teamSpin)) {
+        spin_barrier_destroy(&impl->barrier);
+        impl_free(impl);
         return false;
     }
 
-    pthread_mutex_init(&impl->m, NULL);
-    pthread_cond_init(&impl->cvStart, NULL);
-    pthread_cond_init(&impl->cvDone, NULL);
-
-    for (size_t i = 0; i < threadCount; i++) {
-        impl->ctx[i] = (WorkerCtx){.id = i, .impl = impl};
-        if (pthread_create(&impl->threads[i], NULL, worker_main, &impl->ctx[i]) != 0) {
+    pthread_mutex_init(&impl->startGate, NULL);
+    pthread_mutex_lock(&impl->startGate);
+    for (size_t i = 0; i < threadCount; i++) impl->ctx[i] = (WorkerCtx){.id = i, .impl = impl};
+    for (size_t i = 0; i < impl->workerCount; i++) {
+        WorkerCtx* ctx = &impl->ctx[callerWorks ? i + 1 : i];
+        if (pthread_create(&impl->threads[i], NULL, worker_main, ctx) != 0) {
+            /* nobody has reached the barrier yet, so it can be resized for the started workers */
+            spin_barrier_destroy(&impl->barrier);
+            (void)spin_barrier_init(&impl->barrier, i + 1, 0);
             impl->stop = true;
-            pthread_cond_broadcast(&impl->cvStart);
+            pthread_mutex_unlock(&impl->startGate);
+            spin_barrier_wait(&impl->barrier, &impl->callerSense);
             for (size_t j = 0; j < i; j++) pthread_join(impl->threads[j], NULL);
-            pthread_mutex_destroy(&impl->m);
-            pthread_cond_destroy(&impl->cvStart);
-            pthread_cond_destroy(&impl->cvDone);
-            free(impl->threads);
-            free(impl->ctx);
-            free(impl);
+            spin_barrier_destroy(&impl->barrier);
+            spin_barrier_destroy(&impl->team);
+            pthread_mutex_destroy(&impl->startGate);
+            impl_free(impl);
             return false;
         }
     }
+    pthread_mutex_unlock(&impl->startGate);
 
     u->threadCount = threadCount;
     u->impl = impl;
@@ -107,42 +150,255 @@ void update_pthreads_destroy(UpdatePthreads* u) {
     if (!u || !u->impl) return;
     Impl* impl = (Impl*)u->impl;
 
-    pthread_mutex_lock(&impl->m);
     impl->stop = true;
-    pthread_cond_broadcast(&impl->cvStart);
-    pthread_mutex_unlock(&impl->m);
+    if (impl->workerCount > 0) spin_barrier_wait(&impl->barrier, &impl->callerSense);
 
-    for (size_t i = 0; i < impl->threadCount; i++) {
+    for (size_t i = 0; i < impl->workerCount; i++) {
         pthread_join(impl->threads[i], NULL);
     }
 
-    pthread_mutex_destroy(&impl->m);
-    pthread_cond_destroy(&impl->cvStart);
-    pthread_cond_destroy(&impl->cvDone);
-
-    free(impl->threads);
-    free(impl->ctx);
-    free(impl);
+    spin_barrier_destroy(&impl->barrier);
+    spin_barrier_destroy(&impl->team);
+    pthread_mutex_destroy(&impl->startGate);
+    impl_free(impl);
 
     u->impl = NULL;
     u->threadCount = 0;
 }
 
-void update_pthreads_step(UpdatePthreads* u, World* w, double dt) {
+void update_pthreads_set_spin(UpdatePthreads* u, unsigned spinLimit) {
+    if (!u || !u->impl) return;
+    spin_barrier_set_spin(&((Impl*)u->impl)->barrier, spinLimit);
+    spin_barrier_set_spin(&((Impl*)u->impl)->team, spinLimit);
+}
+
+void update_pthreads_set_schedule(UpdatePthreads* u, UpdateSchedule schedule, size_t chunkSize) {
+    if (!u || !u->impl) return;
     Impl* impl = (Impl*)u->impl;
+    impl->schedule = schedule;
+    impl->chunkSize = chunkSize > 0 ? chunkSize : UPDATE_DEFAULT_CHUNK;
+}
 
-    pthread_mutex_lock(&impl->m);
-    impl->worldRead = w;
-    impl->worldWrite = w;
-    impl->dt = dt;
-    impl->finished = 0;
-    impl->hasWork = true;
-    pthread_cond_broadcast(&impl->cvStart);
+const char* update_schedule_name(UpdateSchedule schedule) {
+    switch (schedule) {
+        case UPDATE_SCHEDULE_STATIC: return "static";
+        case UPDATE_SCHEDULE_CHUNKED: return "chunked";
+        case UPDATE_SCHEDULE_COST: return "cost";
+    }
+    return "unknown";
+}
 
-    while (impl->hasWork) {
-        pthread_cond_wait(&impl->cvDone, &impl->m);
+void update_pthreads_reset_stats(UpdatePthreads* u) {
+    if (!u || !u->impl) return;
+    Impl* impl = (Impl*)u->impl;
+    impl->wallNs = 0;
+    for (size_t i = 0; i < impl->threadCount; i++) {
+        impl->ctx[i].busyNs = 0;
+        impl->ctx[i].teamWaitNs = 0;
     }
-    pthread_mutex_unlock(&impl->m);
+}
+
+bool update_pthreads_thread_stats(const UpdatePthreads* u, size_t thread, UpdateThreadStats* out) {
+    if (!u || !u->impl || !out) return false;
+    const Impl* impl = (const Impl*)u->impl;
+    if (thread >= impl->threadCount) return false;
+    const uint64_t busy = impl->ctx[thread].busyNs - impl->ctx[thread].teamWaitNs;
+    out->busyMs = (double)busy / 1e6;
+    out->idleMs = impl->wallNs > busy ? (double)(impl->wallNs - busy) / 1e6 : 0.0;
+    return true;
+}
+
+/* runs fn once per part (part = ctx id, the caller takes part 0 when it works) and waits for all */
+static void run_parts(void* ctx, WorldPartFn fn, void* arg) {
+    Impl* impl = (Impl*)ctx;
+    uint64_t t0 = now_ns();
 
+    impl->fn = fn;
+    impl->arg = arg;
+    if (impl->workerCount > 0) spin_barrier_wait(&impl->barrier, &impl->callerSense);
+    TRACE_SPAN("dispatch", t0, now_ns());
+    if (impl->callerWorks) {
+        uint64_t t1 = now_ns();
+        fn(arg, 0, impl->threadCount);
+        uint64_t t2 = now_ns();
+        impl->ctx[0].busyNs += t2 - t1;
+        TRACE_SPAN("part", t1, t2);
+    }
+    TRACE_BEGIN(join);
+    if (impl->workerCount > 0) spin_barrier_wait(&impl->barrier, &impl->callerSense);
+    TRACE_END(join, "join");
+    impl->wallNs += now_ns() - t0;
+}
+
+typedef struct PinJob {
+    const int* cpus;
+    atomic_bool failed;
+} PinJob;
+
+static void pin_part(void* arg, size_t part, size_t partCount) {
+    PinJob* job = (PinJob*)arg;
+    (void)partCount;
+    if (!cpu_pin_current_thread(job->cpus[part])) atomic_store(&job->failed, true);
+}
+
+bool update_pthreads_pin(UpdatePthreads* u, const int* cpus) {
+    if (!u || !u->impl || !cpus) return false;
+    PinJob job = {.cpus = cpus};
+
+    atomic_init(&job.failed, false);
+    run_parts(u->impl, pin_part, &job);
+    return !atomic_load(&job.failed);
+}
+
+WorldParallel update_pthreads_parallel(UpdatePthreads* u) {
+    WorldParallel par = {run_parts, u->impl, u->threadCount};
+    return par;
+}
+
+typedef struct StepJob {
+    const World* worldRead;
+    World* worldWrite;
+    double dt;
+    size_t chunkSize;
+    atomic_size_t nextBoid; /* chunk cursor of the chunked schedule */
+    const size_t* bounds;   /* slices of the cost schedule */
+    WorldStepTally* tallies; /* per part */
+} StepJob;
+
+static void step_part(void* arg, size_t part, size_t partCount) {
+    StepJob* job = (StepJob*)arg;
+    size_t begin = (job->worldRead->boidCount * part) / partCount;
+    size_t end = (job->worldRead->boidCount * (part + 1)) / partCount;
+
+    TRACE_BEGIN(t0);
+    world_step_range(job->worldRead, job->worldWrite, begin, end, job->dt, &job->tallies[part]);
+    TRACE_END(t0, "world_step_range");
+}
+
+static void step_part_cost(void* arg, size_t part, size_t partCount) {
+    StepJob* job = (StepJob*)arg;
+    (void)partCount;
+
+    TRACE_BEGIN(t0);
+    world_step_range(job->worldRead, job->worldWrite, job->bounds[part], job->bounds[part + 1], job->dt,
+                     &job->tallies[part]);
+    TRACE_END(t0, "world_step_range");
+}
+
+/* dense flocks cost more per boid than sparse ones, so small chunks go to whoever is free */
+static void step_part_chunked(void* arg, size_t part, size_t partCount) {
+    StepJob* job = (StepJob*)arg;
+    const size_t count = job->worldRead->boidCount;
+    (void)partCount;
+
+    while (true) {
+        size_t begin = atomic_fetch_add_explicit(&job->nextBoid, job->chunkSize, memory_order_relaxed);
+        if (begin >= count) break;
+        size_t end = begin + job->chunkSize < count ? begin + job->chunkSize : count;
+        TRACE_BEGIN(t0);
+        world_step_range(job->worldRead, job->worldWrite, begin, end, job->dt, &job->tallies[part]);
+        TRACE_END(t0, "world_step_range");
+    }
+}
+
+/* one tick; par runs the parallel passes, the step included */
+static void step_tick(Impl* impl, World* w, double dt, const WorldParallel* par) {
+    StepJob job = {.worldRead = w, .worldWrite = w, .dt = dt, .chunkSize = impl->chunkSize, .bounds = impl->bounds,
+                   .tallies = impl->tallies};
+    WorldPartFn stepFn = step_part;
+    PhaseLap lap = profiler_lap_start(w->profiler);
+
+    for (size_t p = 0; p < impl->threadCount; p++) impl->tallies[p] = (WorldStepTally){0, 0, 0};
+    atomic_init(&job.nextBoid, 0);
+    world_reorder_if_due(w, par);
+    profiler_lap(&lap, PROF_SIM_REORDER);
+    world_prepare_step(w, par);
+    profiler_lap(&lap, PROF_SIM_GRID);
+    if (impl->schedule == UPDATE_SCHEDULE_CHUNKED) {
+        stepFn = step_part_chunked;
+    } else if (impl->schedule == UPDATE_SCHEDULE_COST) {
+        world_cost_partition(w, impl->threadCount, impl->bounds);
+        stepFn = step_part_cost;
+    }
+    par->run(par->ctx, stepFn, &job);
+
+    /* fixed part order, so the result does not depend on which worker finished first */
+    w->tally = (WorldStepTally){0, 0, 0};
+    for (size_t p = 0; p < impl->threadCount; p++) {
+        w->tally.kills += impl->tallies[p].kills;
+        w->tally.hits += impl->tallies[p].hits;
+        w->tally.pairs += impl->tallies[p].pairs;
+    }
+    w->stepPairs += w->tally.pairs;
+    profiler_lap(&lap, PROF_SIM_STEP);
     world_swap_buffers(w);
+    profiler_lap(&lap, PROF_SIM_SWAP);
+}
+
+void update_pthreads_step(UpdatePthreads* u, World* w, double dt) {
+    WorldParallel par = update_pthreads_parallel(u);
+    step_tick((Impl*)u->impl, w, dt, &par);
+}
+
+/*
+   update_pthreads_run: every part enters team_part once. Part 0 leads the ticks (the serial
+   bits: grid build, partition, tally, swap) and hands each parallel pass to the others through
+   job->fn and the team barrier; a NULL fn ends the run.
+*/
+typedef struct TeamJob {
+    Impl* impl;
+    World* world;
+    double dt;
+    size_t ticks;
+    WorldPartFn fn;
+    void* arg;
+} TeamJob;
+
+static void team_wait(Impl* impl, size_t part) {
+    WorkerCtx* ctx = &impl->ctx[part];
+    uint64_t t0 = now_ns();
+    spin_barrier_wait(&impl->team, &ctx->teamSense);
+    uint64_t t1 = now_ns();
+    ctx->teamWaitNs += t1 - t0;
+    TRACE_SPAN("team_barrier", t0, t1);
+}
+
+/* WorldParallel.run of the leader inside a run */
+static void team_run(void* ctx, WorldPartFn fn, void* arg) {
+    TeamJob* job = (TeamJob*)ctx;
+
+    job->fn = fn;
+    job->arg = arg;
+    team_wait(job->impl, 0);
+    fn(arg, 0, job->impl->threadCount);
+    team_wait(job->impl, 0);
+}
+
+static void team_part(void* arg, size_t part, size_t partCount) {
+    TeamJob* job = (TeamJob*)arg;
+    Impl* impl = job->impl;
+
+    if (part == 0) {
+        WorldParallel par = {team_run, job, partCount};
+        for (size_t t = 0; t < job->ticks; t++) step_tick(impl, job->world, job->dt, &par);
+        job->fn = NULL;
+        team_wait(impl, 0);
+        return;
+    }
+
+    while (true) {
+        /* fn and arg are written by the leader before the barrier and read after it */
+        team_wait(impl, part);
+        if (!job->fn) break;
+        job->fn(job->arg, part, partCount);
+        team_wait(impl, part);
+    }
+}
+
+void update_pthreads_run(UpdatePthreads* u, World* w, double dt, size_t ticks) {
+    Impl* impl = (Impl*)u->impl;
+    TeamJob job = {.impl = impl, .world = w, .dt = dt, .ticks = ticks};
+
+    if (ticks == 0) return;
+    run_parts(impl, team_part, &job);
 }
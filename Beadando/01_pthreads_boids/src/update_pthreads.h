@@ -7,11 +7,54 @@
 
 typedef struct UpdatePthreads UpdatePthreads;
 
+typedef enum UpdateSchedule {
+    UPDATE_SCHEDULE_STATIC = 0, /* one contiguous slice per worker */
+    UPDATE_SCHEDULE_CHUNKED,    /* workers pull fixed-size chunks from a shared cursor */
+    UPDATE_SCHEDULE_COST,       /* one slice per worker, sized by the cost of the previous tick */
+} UpdateSchedule;
+
+enum {
+    UPDATE_DEFAULT_CHUNK = 256,
+};
+
+typedef struct UpdateThreadStats {
+    double busyMs; /* inside parallel work */
+    double idleMs; /* waiting for the slowest worker of the same runs */
+} UpdateThreadStats;
+
 struct UpdatePthreads {
     size_t threadCount;
     void* impl;
 };
 
-bool update_pthreads_init(UpdatePthreads* updater, size_t threadCount);
+/*
+   threadCount is the number of parts per run. With callerWorks the calling thread runs part 0
+   itself and only threadCount - 1 workers are started; otherwise it just waits for threadCount workers.
+*/
+bool update_pthreads_init(UpdatePthreads* updater, size_t threadCount, bool callerWorks);
 void update_pthreads_destroy(UpdatePthreads* updater);
+/* one tick: re-sort if due, prepare, parallel step, swap; fills world->tally */
 void update_pthreads_step(UpdatePthreads* updater, World* world, double dt);
+/*
+   ticks back-to-back with the same result as calling update_pthreads_step that many times, but
+   the parts stay inside one run: between the phases only they meet, at their own barrier, and the
+   calling thread joins just at the start and the end (or leads as part 0 when it works).
+*/
+void update_pthreads_run(UpdatePthreads* updater, World* world, double dt, size_t ticks);
+/* how long threads spin at the tick barrier before they sleep (0 = sleep right away) */
+void update_pthreads_set_spin(UpdatePthreads* updater, unsigned spinLimit);
+/* how the boid step is split between the workers; chunkSize is in boids (0 = default) */
+void update_pthreads_set_schedule(UpdatePthreads* updater, UpdateSchedule schedule, size_t chunkSize);
+const char* update_schedule_name(UpdateSchedule schedule);
+
+/*
+   Binds the thread running part p to cpus[p] (threadCount entries, see cpu_pin_plan); with
+   callerWorks that includes the calling thread. Returns false if any bind failed.
+*/
+bool update_pthreads_pin(UpdatePthreads* updater, const int* cpus);
+
+void update_pthreads_reset_stats(UpdatePthreads* updater);
+bool update_pthreads_thread_stats(const UpdatePthreads* updater, size_t thread, UpdateThreadStats* out);
+
+/* WorldParallel that runs the parts on the worker threads, valid while the updater lives */
+WorldParallel update_pthreads_parallel(UpdatePthreads* updater);
@@ -0,0 +1,180 @@
+#include "updater.h"
+
+#include "profiler.h"
+
+#include <string.h>
+
+/* seq: everything on the calling thread */
+
+static bool seq_init(Updater* u, const UpdaterOptions* opt) {
+    (void)opt;
+    u->threadCount = 1;
+    return true;
+}
+
+static void seq_destroy(Updater* u) {
+    (void)u;
+}
+
+static void seq_step(Updater* u, World* w, double dt) {
+    PhaseLap lap = profiler_lap_start(w->profiler);
+
+    (void)u;
+    world_reorder_if_due(w, NULL);
+    profiler_lap(&lap, PROF_SIM_REORDER);
+    world_prepare_step(w, NULL);
+    profiler_lap(&lap, PROF_SIM_GRID);
+    w->tally = (WorldStepTally){0, 0, 0};
+    world_step_range(w, w, 0, w->boidCount, dt, &w->tally);
+    w->stepPairs += w->tally.pairs;
+    profiler_lap(&lap, PROF_SIM_STEP);
+    world_swap_buffers(w);
+    profiler_lap(&lap, PROF_SIM_SWAP);
+}
+
+static bool seq_parallel(Updater* u, WorldParallel* out) {
+    (void)u;
+    (void)out;
+    return false;
+}
+
+/* pthread */
+
+static bool pthread_backend_init(Updater* u, const UpdaterOptions* opt) {
+    if (!update_pthreads_init(&u->backend.pthreads, opt->threadCount, opt->callerWorks)) return false;
+    if (opt->spinLimit >= 0) update_pthreads_set_spin(&u->backend.pthreads, (unsigned)opt->spinLimit);
+    update_pthreads_set_schedule(&u->backend.pthreads, opt->schedule, opt->chunkSize);
+    u->threadCount = opt->threadCount;
+    return true;
+}
+
+static void pthread_backend_destroy(Updater* u) {
+    update_pthreads_destroy(&u->backend.pthreads);
+}
+
+static void pthread_backend_step(Updater* u, World* w, double dt) {
+    update_pthreads_step(&u->backend.pthreads, w, dt);
+}
+
+static bool pthread_backend_parallel(Updater* u, WorldParallel* out) {
+    *out = update_pthreads_parallel(&u->backend.pthreads);
+    return true;
+}
+
+static void pthread_backend_run(Updater* u, World* w, double dt, size_t ticks) {
+    update_pthreads_run(&u->backend.pthreads, w, dt, ticks);
+}
+
+static bool pthread_backend_pin(Updater* u, const int* cpus) {
+    return update_pthreads_pin(&u->backend.pthreads, cpus);
+}
+
+static void pthread_backend_reset_stats(Updater* u) {
+    update_pthreads_reset_stats(&u->backend.pthreads);
+}
+
+static bool pthread_backend_thread_stats(const Updater* u, size_t thread, UpdateThreadStats* out) {
+    return update_pthreads_thread_stats(&u->backend.pthreads, thread, out);
+}
+
+/* openmp */
+
+static bool openmp_backend_init(Updater* u, const UpdaterOptions* opt) {
+    if (!update_openmp_init(&u->backend.openmp, opt->threadCount)) return false;
+    update_openmp_set_schedule(&u->backend.openmp, opt->schedule, opt->chunkSize);
+    u->threadCount = opt->threadCount;
+    return true;
+}
+
+static void openmp_backend_destroy(Updater* u) {
+    update_openmp_destroy(&u->backend.openmp);
+}
+
+static void openmp_backend_step(Updater* u, World* w, double dt) {
+    update_openmp_step(&u->backend.openmp, w, dt);
+}
+
+static bool openmp_backend_parallel(Updater* u, WorldParallel* out) {
+    *out = update_openmp_parallel(&u->backend.openmp);
+    return true;
+}
+
+static void openmp_backend_reset_stats(Updater* u) {
+    update_openmp_reset_stats(&u->backend.openmp);
+}
+
+static bool openmp_backend_thread_stats(const Updater* u, size_t thread, UpdateThreadStats* out) {
+    return update_openmp_thread_stats(&u->backend.openmp, thread, out);
+}
+
+static const UpdaterOps g_updaterOps[UPDATER_KIND_COUNT] = {
+    [UPDATER_SEQ] = {
+        .name = "seq",
+        .init = seq_init,
+        .destroy = seq_destroy,
+        .step = seq_step,
+        .parallel = seq_parallel,
+    },
+    [UPDATER_PTHREAD] = {
+        .name = "pthread",
+        .init = pthread_backend_init,
+        .destroy = pthread_backend_destroy,
+        .step = pthread_backend_step,
+        .parallel = pthread_backend_parallel,
+        .run = pthread_backend_run,
+        .pin = pthread_backend_pin,
+        .reset_stats = pthread_backend_reset_stats,
+        .thread_stats = pthread_backend_thread_stats,
+    },
+    [UPDATER_OPENMP] = {
+        .name = "openmp",
+        .init = openmp_backend_init,
+        .destroy = openmp_backend_destroy,
+        .step = openmp_backend_step,
+        .parallel = openmp_backend_parallel,
+        .reset_stats = openmp_backend_reset_stats,
+        .thread_stats = openmp_backend_thread_stats,
+    },
+};
+
+const char* updater_kind_name(UpdaterKind kind) {
+    if (kind < 0 || kind >= UPDATER_KIND_COUNT) return "unknown";
+    return g_updaterOps[kind].name;
+}
+
+const UpdaterOps* updater_ops(UpdaterKind kind) {
+    if (kind < 0 || kind >= UPDATER_KIND_COUNT) return NULL;
+    if (kind == UPDATER_OPENMP && !update_openmp_available()) return NULL;
+    return &g_updaterOps[kind];
+}
+
+bool updater_init(Updater* u, UpdaterKind kind, const UpdaterOptions* opt) {
+    const UpdaterOps* ops = updater_ops(kind);
+
+    memset(u, 0, sizeof(*u));
+    if (!ops || !ops->init(u, opt)) return false;
+    u->ops = ops;
+    return true;
+}
+
+void updater_destroy(Updater* u) {
+    if (!u || !u->ops) return;
+    u->ops->destroy(u);
+    u->ops = NULL;
+}
+
+void updater_step(Updater* u, World* w, double dt) {
+    u->ops->step(u, w, dt);
+}
+
+void updater_run(Updater* u, World* w, double dt, size_t ticks) {
+    if (u->ops->run) {
+        if (ticks > 0) u->ops->run(u, w, dt, ticks);
+        return;
+    }
+    for (size_t t = 0; t < ticks; t++) u->ops->step(u, w, dt);
+}
+
+const WorldParallel* updater_parallel(Updater* u, WorldParallel* storage) {
+    return u->ops->parallel(u, storage) ? storage : NULL;
+}
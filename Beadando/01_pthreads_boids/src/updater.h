@@ -0,0 +1,64 @@
+#pragma once
+
+#include "boids.h"
+#include "update_openmp.h"
+#include "update_pthreads.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef enum UpdaterKind {
+    UPDATER_SEQ = 0,
+    UPDATER_PTHREAD,
+    UPDATER_OPENMP,
+    UPDATER_KIND_COUNT,
+} UpdaterKind;
+
+typedef struct UpdaterOptions {
+    size_t threadCount;
+    bool callerWorks;        /* pthread: the calling thread runs part 0 */
+    int spinLimit;           /* pthread: tick barrier spin rounds, -1 = default */
+    UpdateSchedule schedule; /* pthread, openmp */
+    size_t chunkSize;
+} UpdaterOptions;
+
+typedef struct Updater Updater;
+
+/*
+   Backend interface of the world update. Every backend steps the same World with the same
+   result; they differ only in who runs the parallel passes. Optional entries may be NULL.
+*/
+typedef struct UpdaterOps {
+    const char* name;
+    bool (*init)(Updater* u, const UpdaterOptions* opt);
+    void (*destroy)(Updater* u);
+    void (*step)(Updater* u, World* w, double dt);
+    /* false when the backend runs everything on the calling thread */
+    bool (*parallel)(Updater* u, WorldParallel* out);
+    /* optional */
+    void (*run)(Updater* u, World* w, double dt, size_t ticks);
+    bool (*pin)(Updater* u, const int* cpus);
+    void (*reset_stats)(Updater* u);
+    bool (*thread_stats)(const Updater* u, size_t thread, UpdateThreadStats* out);
+} UpdaterOps;
+
+struct Updater {
+    const UpdaterOps* ops;
+    size_t threadCount;
+    union {
+        UpdatePthreads pthreads;
+        UpdateOpenmp openmp;
+    } backend;
+};
+
+const char* updater_kind_name(UpdaterKind kind);
+/* NULL if the kind is not built in (openmp without -fopenmp) */
+const UpdaterOps* updater_ops(UpdaterKind kind);
+
+bool updater_init(Updater* u, UpdaterKind kind, const UpdaterOptions* opt);
+void updater_destroy(Updater* u);
+void updater_step(Updater* u, World* w, double dt);
+/* ticks in a row; backends without a run entry fall back to a step loop */
+void updater_run(Updater* u, World* w, double dt, size_t ticks);
+/* NULL (serial) for the sequential backend, otherwise storage */
+const WorldParallel* updater_parallel(Updater* u, WorldParallel* storage);
@@ -94,6 +94,118 @@ static Vec2 steer_towards(Vec2 desiredVel, Vec2 currentVel, float maxForce) {
     return v_limit(v_sub(desiredVel, currentVel), maxForce);
 }
 
+/* must not be smaller than the largest radius in world_step_range (predAvoidRadius) */
+#define GRID_MIN_CELL_SIZE 12.0f
+
+static bool grid_init(BoidGrid* grid, size_t boidCount) {
+    memset(grid, 0, sizeof(*grid));
+    grid->cellStart = (size_t*)calloc(2, sizeof(size_t));
+    grid->cellBoids = (size_t*)calloc(boidCount, sizeof(size_t));
+    grid->boidCell = (size_t*)calloc(boidCount, sizeof(size_t));
+    if (!grid->cellStart || !grid->cellBoids || !grid->boidCell) {
+        free(grid->cellStart);
+        free(grid->cellBoids);
+        free(grid->boidCell);
+        memset(grid, 0, sizeof(*grid));
+        return false;
+    }
+    grid->cellCapacity = 1;
+    grid->cols = 1;
+    grid->rows = 1;
+    return true;
+}
+
+static void grid_destroy(BoidGrid* grid) {
+    free(grid->cellStart);
+    free(grid->cellBoids);
+    free(grid->boidCell);
+    memset(grid, 0, sizeof(*grid));
+}
+
+static bool grid_reserve_cells(BoidGrid* grid, size_t cellCount) {
+    size_t* cellStart;
+
+    if (cellCount <= grid->cellCapacity) return true;
+
+    cellStart = (size_t*)realloc(grid->cellStart, (cellCount + 1) * sizeof(size_t));
+    if (!cellStart) return false;
+    grid->cellStart = cellStart;
+    grid->cellCapacity = cellCount;
+    return true;
+}
+
+static size_t grid_cell_of(const BoidGrid* grid, Vec2 pos) {
+    int cx = (int)(pos.x / grid->cellW);
+    int cy = (int)(pos.y / grid->cellH);
+
+    if (cx < 0) cx = 0;
+    else if (cx >= grid->cols) cx = grid->cols - 1;
+    if (cy < 0) cy = 0;
+    else if (cy >= grid->rows) cy = grid->rows - 1;
+
+    return (size_t)cy * (size_t)grid->cols + (size_t)cx;
+}
+
+/* neighboring cell indices along one axis; narrow grids list every cell once so nothing is visited twice */
+static int grid_axis_span(int c, int count, int out[3]) {
+    if (count < 3) {
+        for (int k = 0; k < count; k++) out[k] = k;
+        return count;
+    }
+    out[0] = (c == 0) ? count - 1 : c - 1;
+    out[1] = c;
+    out[2] = (c == count - 1) ? 0 : c + 1;
+    return 3;
+}
+
+static void world_prepare_step(World* world) {
+    BoidGrid* grid = &world->grid;
+    int cols = (int)((float)world->width / GRID_MIN_CELL_SIZE);
+    int rows = (int)((float)world->height / GRID_MIN_CELL_SIZE);
+    size_t cellCount;
+    size_t sum = 0;
+
+    if (cols < 1) cols = 1;
+    if (rows < 1) rows = 1;
+    if (!grid_reserve_cells(grid, (size_t)cols * (size_t)rows)) {
+        /* a single cell degrades to the plain all-pairs scan */
+        cols = 1;
+        rows = 1;
+    }
+
+    grid->cols = cols;
+    grid->rows = rows;
+    grid->cellW = (float)world->width / (float)cols;
+    grid->cellH = (float)world->height / (float)rows;
+    cellCount = (size_t)cols * (size_t)rows;
+
+    /* counting sort: count, exclusive prefix, scatter, then shift the cursors back into starts */
+    memset(grid->cellStart, 0, (cellCount + 1) * sizeof(size_t));
+    for (size_t i = 0; i < world->boidCount; i++) {
+        if (!world->boids[i].alive) {
+            grid->boidCell[i] = cellCount;
+            continue;
+        }
+        grid->boidCell[i] = grid_cell_of(grid, world->boids[i].pos);
+        grid->cellStart[grid->boidCell[i]]++;
+    }
+
+    for (size_t c = 0; c < cellCount; c++) {
+        size_t count = grid->cellStart[c];
+        grid->cellStart[c] = sum;
+        sum += count;
+    }
+
+    for (size_t i = 0; i < world->boidCount; i++) {
+        size_t c = grid->boidCell[i];
+        if (c == cellCount) continue;
+        grid->cellBoids[grid->cellStart[c]++] = i;
+    }
+
+    memmove(grid->cellStart + 1, grid->cellStart, cellCount * sizeof(size_t));
+    grid->cellStart[0] = 0;
+}
+
 bool world_init(World* world, int width, int height, size_t boidCount) {
     Vec2 centers[16];
     Vec2 dirs[16];
@@ -107,9 +219,11 @@ bool world_init(World* world, int width, int height, size_t boidCount) {
 
     world->boids = (Boid*)calloc(boidCount, sizeof(Boid));
     world->boidsNext = (Boid*)calloc(boidCount, sizeof(Boid));
-    if (!world->boids || !world->boidsNext) {
+    world->stepCost = (uint32_t*)calloc(boidCount ? boidCount : 1, sizeof(uint32_t));
+    if (!world->boids || !world->boidsNext || !world->stepCost || !grid_init(&world->grid, boidCount)) {
         free(world->boids);
         free(world->boidsNext);
+        free(world->stepCost);
         memset(world, 0, sizeof(*world));
         return false;
     }
@@ -167,6 +281,8 @@ bool world_init(World* world, int width, int height, size_t boidCount) {
 
     world->player.pos = (Vec2){(float)(width / 2), (float)(height / 2)};
     world->player.speed = 25.0f;
+
+    world_prepare_step(world);
     return true;
 }
 
@@ -174,6 +290,9 @@ void world_destroy(World* world) {
     if (!world) return;
     free(world->boids);
     free(world->boidsNext);
+    free(world->stepCost);
+    free(world->partBounds);
+    grid_destroy(&world->grid);
     memset(world, 0, sizeof(*world));
 }
 
@@ -220,32 +339,54 @@ static void world_step_range(const World* worldRead, World* worldWrite, size_t b
     const float predAvoidRadius2 = predAvoidRadius * predAvoidRadius;
     const float weightAvoidPred = 2.20f;
 
+    const BoidGrid* grid = &worldRead->grid;
+
     for (size_t i = begin; i < end; i++) {
         Boid boid = worldRead->boids[i];
+        size_t cell;
+        int spanX[3];
+        int spanY[3];
+        int spanCountX;
+        int spanCountY;
+        size_t cost;
 
         if (!boid.alive) {
             worldWrite->boidsNext[i] = boid;
+            worldWrite->stepCost[i] = 1;
             continue;
         }
 
+        /* fixed per-boid work plus one unit per neighbor candidate */
+        cost = 8;
+        cell = grid->boidCell[i];
+        spanCountX = grid_axis_span((int)(cell % (size_t)grid->cols), grid->cols, spanX);
+        spanCountY = grid_axis_span((int)(cell / (size_t)grid->cols), grid->rows, spanY);
+
         if (boid.predator) {
             Vec2 sumSep = {0, 0};
 
-            for (size_t j = 0; j < worldRead->boidCount; j++) {
-                float dx;
-                float dy;
-                float d2;
+            for (int cy = 0; cy < spanCountY; cy++) {
+                for (int cx = 0; cx < spanCountX; cx++) {
+                    size_t c = (size_t)spanY[cy] * (size_t)grid->cols + (size_t)spanX[cx];
+
+                    cost += grid->cellStart[c + 1] - grid->cellStart[c];
+                    for (size_t k = grid->cellStart[c]; k < grid->cellStart[c + 1]; k++) {
+                        size_t j = grid->cellBoids[k];
+                        float dx;
+                        float dy;
+                        float d2;
 
-                if (i == j) continue;
-                if (!worldRead->boids[j].alive) continue;
+                        if (i == j) continue;
 
-                dx = torus_delta(worldRead->boids[j].pos.x - boid.pos.x, worldW);
-                dy = torus_delta(worldRead->boids[j].pos.y - boid.pos.y, worldH);
-                d2 = dx * dx + dy * dy;
+                        dx = torus_delta(worldRead->boids[j].pos.x - boid.pos.x, worldW);
+                        dy = torus_delta(worldRead->boids[j].pos.y - boid.pos.y, worldH);
+                        d2 = dx * dx + dy * dy;
 
-                if (d2 < predSepRadius2 && d2 > 1e-6f) {
-                    Vec2 away = v_mul(v_norm((Vec2){dx, dy}), -1.0f);
-                    sumSep = v_add(sumSep, v_div(away, sqrtf(d2)));
+                        if (d2 < predSepRadius2 && d2 > 1e-6f) {
+                            Vec2 away = v_mul(v_norm((Vec2){dx, dy}), -1.0f);
+                            sumSep = v_add(sumSep, v_div(away, sqrtf(d2)));
+                        }
+                    }
                 }
             }
 
@@ -272,6 +413,7 @@ static void world_step_range(const World* worldRead, World* worldWrite, size_t b
             }
 
             worldWrite->boidsNext[i] = boid;
+            worldWrite->stepCost[i] = (uint32_t)cost;
             continue;
         }
 
@@ -283,37 +425,44 @@ static void world_step_range(const World* worldRead, World* worldWrite, size_t b
             Vec2 sumPred = {0, 0};
             int neighbors = 0;
 
-            for (size_t j = 0; j < worldRead->boidCount; j++) {
-                float dx;
-                float dy;
-                float d2;
-
-                if (i == j) continue;
-                if (!worldRead->boids[j].alive) continue;
-
-                dx = torus_delta(worldRead->boids[j].pos.x - boid.pos.x, worldW);
-                dy = torus_delta(worldRead->boids[j].pos.y - boid.pos.y, worldH);
-                d2 = dx * dx + dy * dy;
-
-                if (d2 < desiredSeparation2 && d2 > 1e-6f) {
-                    Vec2 away = v_mul(v_norm((Vec2){dx, dy}), -1.0f);
-                    sumSep = v_add(sumSep, v_div(away, sqrtf(d2)));
-                }
-
-                if (worldRead->boids[j].predator) {
-                    if (d2 < predAvoidRadius2 && d2 > 1e-6f) {
-                        Vec2 away = v_mul(v_norm((Vec2){dx, dy}), -1.0f);
-                        sumPred = v_add(sumPred, v_div(away, sqrtf(d2)));
+            for (int cy = 0; cy < spanCountY; cy++) {
+                for (int cx = 0; cx < spanCountX; cx++) {
+                    size_t c = (size_t)spanY[cy] * (size_t)grid->cols + (size_t)spanX[cx];
+
+                    cost += grid->cellStart[c + 1] - grid->cellStart[c];
+                    for (size_t k = grid->cellStart[c]; k < grid->cellStart[c + 1]; k++) {
+                        size_t j = grid->cellBoids[k];
+                        float dx;
+                        float dy;
+                        float d2;
+
+                        if (i == j) continue;
+
+                        dx = torus_delta(worldRead->boids[j].pos.x - boid.pos.x, worldW);
+                        dy = torus_delta(worldRead->boids[j].pos.y - boid.pos.y, worldH);
+                        d2 = dx * dx + dy * dy;
+
+                        if (d2 < desiredSeparation2 && d2 > 1e-6f) {
+                            Vec2 away = v_mul(v_norm((Vec2){dx, dy}), -1.0f);
+                            sumSep = v_add(sumSep, v_div(away, sqrtf(d2)));
+                        }
+
+                        if (worldRead->boids[j].predator) {
+                            if (d2 < predAvoidRadius2 && d2 > 1e-6f) {
+                                Vec2 away = v_mul(v_norm((Vec2){dx, dy}), -1.0f);
+                                sumPred = v_add(sumPred, v_div(away, sqrtf(d2)));
+                            }
+                            continue;
+                        }
+
+                        if (worldRead->boids[j].group != group) continue;
+
+                        if (d2 < neighborRadius2) {
+                            neighbors++;
+                            sumPos = v_add(sumPos, v_add(boid.pos, (Vec2){dx, dy}));
+                            sumVel = v_add(sumVel, worldRead->boids[j].vel);
+                        }
                     }
-                    continue;
-                }
-
-                if (worldRead->boids[j].group != group) continue;
-
-                if (d2 < neighborRadius2) {
-                    neighbors++;
-                    sumPos = v_add(sumPos, v_add(boid.pos, (Vec2){dx, dy}));
-                    sumVel = v_add(sumVel, worldRead->boids[j].vel);
                 }
             }
 
@@ -364,6 +513,7 @@ static void world_step_range(const World* worldRead, World* worldWrite, size_t b
         }
 
         worldWrite->boidsNext[i] = boid;
+        worldWrite->stepCost[i] = (uint32_t)cost;
     }
 }
 
@@ -371,11 +521,41 @@ static void world_swap_buffers(World* world) {
     Boid* tmp = world->boids;
     world->boids = world->boidsNext;
     world->boidsNext = tmp;
+    world->stepCostValid = true;
+}
+
+/* bounds[p]..bounds[p + 1] gets about 1/parts of the stepCost total */
+static void world_cost_partition(const World* world, size_t parts, size_t* bounds) {
+    uint64_t total = 0;
+    uint64_t prefix = 0;
+    size_t p = 1;
+
+    for (size_t i = 0; i < world->boidCount; i++) total += world->stepCost[i];
+
+    bounds[0] = 0;
+    for (size_t i = 0; i < world->boidCount && p < parts; i++) {
+        while (p < parts && prefix >= (total * p) / parts) bounds[p++] = i;
+        prefix += world->stepCost[i];
+    }
+    while (p < parts) bounds[p++] = world->boidCount;
+    bounds[parts] = world->boidCount;
+}
+
+static bool world_reserve_part_bounds(World* world, size_t parts) {
+    size_t* bounds;
+
+    if (parts + 1 <= world->partBoundsCapacity) return true;
+    bounds = (size_t*)realloc(world->partBounds, (parts + 1) * sizeof(size_t));
+    if (!bounds) return false;
+    world->partBounds = bounds;
+    world->partBoundsCapacity = parts + 1;
+    return true;
 }
 
 double world_step_seq(World* world, double dt) {
     uint64_t startUs = time_now_us();
 
+    world_prepare_step(world);
     world_step_range(world, world, 0, world->boidCount, dt);
     world_swap_buffers(world);
 
@@ -385,7 +565,13 @@ double world_step_seq(World* world, double dt) {
 double world_step_openmp(World* world, int threads, double dt) {
     uint64_t startUs = time_now_us();
 
+    world_prepare_step(world);
+
 #ifdef _OPENMP
+    const size_t parts = threads > 0 ? (size_t)threads : 1;
+    const bool useCost = world->costPartition && world->stepCostValid && world_reserve_part_bounds(world, parts);
+
+    if (useCost) world_cost_partition(world, parts, world->partBounds);
     omp_set_num_threads(threads);
 
 #pragma omp parallel
@@ -394,6 +580,11 @@ double world_step_openmp(World* world, int threads, double dt) {
         int threadCount = omp_get_num_threads();
         size_t begin = world->boidCount * (size_t)threadIndex / (size_t)threadCount;
         size_t end = world->boidCount * (size_t)(threadIndex + 1) / (size_t)threadCount;
+        /* the runtime may hand out fewer threads than asked, then the even split stays */
+        if (useCost && (size_t)threadCount == parts) {
+            begin = world->partBounds[threadIndex];
+            end = world->partBounds[threadIndex + 1];
+        }
         world_step_range(world, world, begin, end, dt);
     }
 #else
@@ -2,6 +2,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 typedef struct Vec2 {
     float x;
@@ -29,6 +30,22 @@ typedef struct InputState {
     bool quit;
 } InputState;
 
+/*
+   Uniform torus grid rebuilt every tick from World.boids.
+   cellBoids holds the alive boid indices ordered by cell, cellStart[c]..cellStart[c + 1]
+   is the slice of cell c.
+*/
+typedef struct BoidGrid {
+    int cols;
+    int rows;
+    float cellW;
+    float cellH;
+    size_t cellCapacity;
+    size_t* cellStart;
+    size_t* cellBoids;
+    size_t* boidCell;
+} BoidGrid;
+
 typedef struct World {
     int width;
     int height;
@@ -37,6 +54,16 @@ typedef struct World {
     Boid* boids;
     Boid* boidsNext;
     Player player;
+    BoidGrid grid;
+    /*
+       With costPartition, world_step_openmp sizes each thread's range so the neighbor
+       candidates counted in the previous tick (stepCost) split evenly.
+    */
+    bool costPartition;
+    uint32_t* stepCost;
+    bool stepCostValid;
+    size_t* partBounds;
+    size_t partBoundsCapacity;
 } World;
 
 bool world_init(World* world, int width, int height, size_t boidCount);
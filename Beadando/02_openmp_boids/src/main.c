@@ -159,6 +159,7 @@ typedef struct AppConfig {
     bool liveBenchmarkSession;
     int benchmarkSteps;
     int benchmarkWarmup;
+    bool costPartition;
 } AppConfig;
 
 typedef struct BenchmarkResult {
@@ -250,6 +251,7 @@ typedef struct UiAssets {
 static void print_usage(const char* exe) {
     printf("Usage: %s [--mode seq|openmp] [--threads N] [--boids N] [--width W] [--height H] [--game peaceful|survival|terminate44]\n", exe);
     printf("       %s --benchmark N [--compare] [--mode seq|openmp] [--threads N] [--boids N] [--width W] [--height H] [--game peaceful|survival|terminate44]\n", exe);
+    printf("Options: --schedule static|cost splits the OpenMP step into equal boid counts or by the previous tick's neighbor counts (default: static)\n");
     printf("Controls (in window): WASD move player, Q or ESC quit\n");
 }
 
@@ -1204,6 +1206,7 @@ static void app_reset_world_for_mode(AppState* s) {
     }
     world_destroy(&s->world);
     s->world = tmp;
+    s->world.costPartition = s->cfg.costPartition;
 
     s->shockCooldown = 0.0;
     s->shockTime = 0.0;
@@ -1586,8 +1589,9 @@ static void print_benchmark_result(const AppConfig* cfg, const BenchmarkResult*
     char text[512];
 
     snprintf(text, sizeof(text),
-             "benchmark mode=%s game=%s section=world_update_only threads=%d boids=%d size=%dx%d steps=%d total=%.3f ms avg=%.3f ms/tick ticks=%.2f/s\n",
+             "benchmark mode=%s schedule=%s game=%s section=world_update_only threads=%d boids=%d size=%dx%d steps=%d total=%.3f ms avg=%.3f ms/tick ticks=%.2f/s\n",
              run_mode_name(cfg->mode),
+             cfg->costPartition ? "cost" : "static",
              game_mode_name(cfg->gameMode),
              cfg->threadCount,
              cfg->boidCount,
@@ -1647,11 +1651,12 @@ static int run_compare_benchmark(const AppConfig* cfg, double simDt) {
     }
 
     snprintf(text, sizeof(text),
-             "benchmark compare game=%s section=world_update_only boids=%d size=%dx%d steps=%d\n"
+             "benchmark compare game=%s schedule=%s section=world_update_only boids=%d size=%dx%d steps=%d\n"
              "  seq:        avg=%.3f ms/tick | ticks=%.2f/s\n"
              "  openmp(%d): avg=%.3f ms/tick | ticks=%.2f/s\n"
              "  speedup:    %.2fx\n",
              game_mode_name(cfg->gameMode),
+             cfg->costPartition ? "cost" : "static",
              cfg->boidCount,
              cfg->width,
              cfg->height,
@@ -1859,6 +1864,7 @@ int main(int argc, char** argv) {
         .liveBenchmarkSession = false,
         .benchmarkSteps = 0,
         .benchmarkWarmup = BENCHMARK_WARMUP_STEPS,
+        .costPartition = false,
     };
     const double simDt = 1.0 / 120.0;
 
@@ -1901,6 +1907,16 @@ int main(int argc, char** argv) {
                 cfg.benchmarkCompare = true;
                 continue;
             }
+            if (strcmp(argv[i], "--schedule") == 0 && i + 1 < argc) {
+                const char* sm = argv[++i];
+                if (strcmp(sm, "static") == 0) cfg.costPartition = false;
+                else if (strcmp(sm, "cost") == 0) cfg.costPartition = true;
+                else {
+                    fprintf(stderr, "Unknown schedule: %s\n", sm);
+                    return 2;
+                }
+                continue;
+            }
             if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) { cfg.threadCount = parse_int(argv[++i], cfg.threadCount); continue; }
             if (strcmp(argv[i], "--boids") == 0 && i + 1 < argc) { cfg.boidCount = parse_int(argv[++i], cfg.boidCount); continue; }
             if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) { cfg.width = parse_int(argv[++i], cfg.width); continue; }
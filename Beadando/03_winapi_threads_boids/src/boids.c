@@ -70,6 +70,70 @@ static Vec2 steer_towards(Vec2 desiredVel, Vec2 currentVel, float maxForce) {
     return v_limit(v_sub(desiredVel, currentVel), maxForce);
 }
 
+/* must not be smaller than the largest radius in world_step_range (predAvoidRadius) */
+#define GRID_MIN_CELL_SIZE 12.0f
+
+static bool grid_init(BoidGrid* g, size_t boidCount) {
+    memset(g, 0, sizeof(*g));
+    g->cellStart = (size_t*)calloc(2, sizeof(size_t));
+    g->cellBoids = (size_t*)calloc(boidCount, sizeof(size_t));
+    g->boidCell = (size_t*)calloc(boidCount, sizeof(size_t));
+    if (!g->cellStart || !g->cellBoids || !g->boidCell) {
+        free(g->cellStart);
+        free(g->cellBoids);
+        free(g->boidCell);
+        memset(g, 0, sizeof(*g));
+        return false;
+    }
+    g->cellCapacity = 1;
+    g->cols = 1;
+    g->rows = 1;
+    return true;
+}
+
+static void grid_destroy(BoidGrid* g) {
+    free(g->cellStart);
+    free(g->cellBoids);
+    free(g->boidCell);
+    memset(g, 0, sizeof(*g));
+}
+
+static bool grid_reserve_cells(BoidGrid* g, size_t cellCount) {
+    size_t* cellStart;
+
+    if (cellCount <= g->cellCapacity) return true;
+
+    cellStart = (size_t*)realloc(g->cellStart, (cellCount + 1) * sizeof(size_t));
+    if (!cellStart) return false;
+    g->cellStart = cellStart;
+    g->cellCapacity = cellCount;
+    return true;
+}
+
+static size_t grid_cell_of(const BoidGrid* g, Vec2 p) {
+    int cx = (int)(p.x / g->cellW);
+    int cy = (int)(p.y / g->cellH);
+
+    if (cx < 0) cx = 0;
+    else if (cx >= g->cols) cx = g->cols - 1;
+    if (cy < 0) cy = 0;
+    else if (cy >= g->rows) cy = g->rows - 1;
+
+    return (size_t)cy * (size_t)g->cols + (size_t)cx;
+}
+
+/* neighboring cell indices along one axis; narrow grids list every cell once so nothing is visited twice */
+static int grid_axis_span(int c, int count, int out[3]) {
+    if (count < 3) {
+        for (int k = 0; k < count; k++) out[k] = k;
+        return count;
+    }
+    out[0] = (c == 0) ? count - 1 : c - 1;
+    out[1] = c;
+    out[2] = (c == count - 1) ? 0 : c + 1;
+    return 3;
+}
+
 bool world_init(World* w, int width, int height, size_t boidCount) {
     memset(w, 0, sizeof(*w));
     w->width = width;
@@ -79,7 +143,7 @@ bool world_init(World* w, int width, int height, size_t boidCount) {
 
     w->boids = (Boid*)calloc(boidCount, sizeof(Boid));
     w->boidsNext = (Boid*)calloc(boidCount, sizeof(Boid));
-    if (!w->boids || !w->boidsNext) {
+    if (!w->boids || !w->boidsNext || !grid_init(&w->grid, boidCount)) {
         free(w->boids);
         free(w->boidsNext);
         return false;
@@ -148,6 +212,8 @@ bool world_init(World* w, int width, int height, size_t boidCount) {
 
     w->player.pos = (Vec2){(float)(width / 2), (float)(height / 2)};
     w->player.speed = 25.0f;
+
+    world_prepare_step(w);
     return true;
 }
 
@@ -155,6 +221,7 @@ void world_destroy(World* w) {
     if (!w) return;
     free(w->boids);
     free(w->boidsNext);
+    grid_destroy(&w->grid);
     memset(w, 0, sizeof(*w));
 }
 
@@ -194,6 +261,7 @@ double world_step_seq(World* w, double dt) {
     t0 = 0;
 #endif
 
+    world_prepare_step(w);
     world_step_range(w, w, 0, w->boidCount, dt);
     tmp = w->boids;
     w->boids = w->boidsNext;
@@ -209,6 +277,54 @@ double world_step_seq(World* w, double dt) {
     return (double)(t1 - t0) / 1000.0;
 }
 
+void world_prepare_step(World* w) {
+    BoidGrid* g = &w->grid;
+    int cols = (int)((float)w->width / GRID_MIN_CELL_SIZE);
+    int rows = (int)((float)w->height / GRID_MIN_CELL_SIZE);
+    size_t cellCount;
+    size_t sum = 0;
+
+    if (cols < 1) cols = 1;
+    if (rows < 1) rows = 1;
+    if (!grid_reserve_cells(g, (size_t)cols * (size_t)rows)) {
+        /* a single cell degrades to the plain all-pairs scan */
+        cols = 1;
+        rows = 1;
+    }
+
+    g->cols = cols;
+    g->rows = rows;
+    g->cellW = (float)w->width / (float)cols;
+    g->cellH = (float)w->height / (float)rows;
+    cellCount = (size_t)cols * (size_t)rows;
+
+    /* counting sort: count, exclusive prefix, scatter, then shift the cursors back into starts */
+    memset(g->cellStart, 0, (cellCount + 1) * sizeof(size_t));
+    for (size_t i = 0; i < w->boidCount; i++) {
+        if (!w->boids[i].alive) {
+            g->boidCell[i] = cellCount;
+            continue;
+        }
+        g->boidCell[i] = grid_cell_of(g, w->boids[i].pos);
+        g->cellStart[g->boidCell[i]]++;
+    }
+
+    for (size_t c = 0; c < cellCount; c++) {
+        size_t count = g->cellStart[c];
+        g->cellStart[c] = sum;
+        sum += count;
+    }
+
+    for (size_t i = 0; i < w->boidCount; i++) {
+        size_t c = g->boidCell[i];
+        if (c == cellCount) continue;
+        g->cellBoids[g->cellStart[c]++] = i;
+    }
+
+    memmove(g->cellStart + 1, g->cellStart, cellCount * sizeof(size_t));
+    g->cellStart[0] = 0;
+}
+
 void world_step_range(const World* r, World* w, size_t begin, size_t end, double dt) {
     const float neighborRadius = 6.5f;
     const float desiredSeparation = 2.2f;
@@ -232,33 +348,49 @@ void world_step_range(const World* r, World* w, size_t begin, size_t end, double
     const float predAvoidRadius = 12.0f;
     const float predAvoidRadius2 = predAvoidRadius * predAvoidRadius;
     const float wAvoidPred = 2.20f;
+    const BoidGrid* g = &r->grid;
 
     for (size_t i = begin; i < end; i++) {
         Boid b = r->boids[i];
+        size_t cell;
+        int spanX[3];
+        int spanY[3];
+        int nx;
+        int ny;
 
         if (!b.alive) {
             w->boidsNext[i] = b;
             continue;
         }
 
+        cell = g->boidCell[i];
+        nx = grid_axis_span((int)(cell % (size_t)g->cols), g->cols, spanX);
+        ny = grid_axis_span((int)(cell / (size_t)g->cols), g->rows, spanY);
+
         if (b.predator) {
             Vec2 sumSep = {0, 0};
 
-            for (size_t j = 0; j < r->boidCount; j++) {
-                float dx;
-                float dy;
-                float d2;
+            for (int cy = 0; cy < ny; cy++) {
+                for (int cx = 0; cx < nx; cx++) {
+                    size_t c = (size_t)spanY[cy] * (size_t)g->cols + (size_t)spanX[cx];
 
-                if (i == j) continue;
-                if (!r->boids[j].alive) continue;
+                    for (size_t k = g->cellStart[c]; k < g->cellStart[c + 1]; k++) {
+                        size_t j = g->cellBoids[k];
+                        float dx;
+                        float dy;
+                        float d2;
 
-                dx = torus_delta(r->boids[j].pos.x - b.pos.x, worldW);
-                dy = torus_delta(r->boids[j].pos.y - b.pos.y, worldH);
-                d2 = dx * dx + dy * dy;
+                        if (i == j) continue;
 
-                if (d2 < predSepRadius2 && d2 > 1e-6f) {
-                    Vec2 away = v_mul(v_norm((Vec2){dx, dy}), -1.0f);
-                    sumSep = v_add(sumSep, v_div(away, sqrtf(d2)));
+                        dx = torus_delta(r->boids[j].pos.x - b.pos.x, worldW);
+                        dy = torus_delta(r->boids[j].pos.y - b.pos.y, worldH);
+                        d2 = dx * dx + dy * dy;
+
+                        if (d2 < predSepRadius2 && d2 > 1e-6f) {
+                            Vec2 away = v_mul(v_norm((Vec2){dx, dy}), -1.0f);
+                            sumSep = v_add(sumSep, v_div(away, sqrtf(d2)));
+                        }
+                    }
                 }
             }
 
@@ -295,37 +427,43 @@ void world_step_range(const World* r, World* w, size_t begin, size_t end, double
             Vec2 sumPred = {0, 0};
             int neighbors = 0;
 
-            for (size_t j = 0; j < r->boidCount; j++) {
-                float dx;
-                float dy;
-                float d2;
-
-                if (i == j) continue;
-                if (!r->boids[j].alive) continue;
-
-                dx = torus_delta(r->boids[j].pos.x - b.pos.x, worldW);
-                dy = torus_delta(r->boids[j].pos.y - b.pos.y, worldH);
-                d2 = dx * dx + dy * dy;
-
-                if (d2 < desiredSeparation2 && d2 > 1e-6f) {
-                    Vec2 away = v_mul(v_norm((Vec2){dx, dy}), -1.0f);
-                    sumSep = v_add(sumSep, v_div(away, sqrtf(d2)));
-                }
-
-                if (r->boids[j].predator) {
-                    if (d2 < predAvoidRadius2 && d2 > 1e-6f) {
-                        Vec2 away = v_mul(v_norm((Vec2){dx, dy}), -1.0f);
-                        sumPred = v_add(sumPred, v_div(away, sqrtf(d2)));
+            for (int cy = 0; cy < ny; cy++) {
+                for (int cx = 0; cx < nx; cx++) {
+                    size_t c = (size_t)spanY[cy] * (size_t)g->cols + (size_t)spanX[cx];
+
+                    for (size_t k = g->cellStart[c]; k < g->cellStart[c + 1]; k++) {
+                        size_t j = g->cellBoids[k];
+                        float dx;
+                        float dy;
+                        float d2;
+
+                        if (i == j) continue;
+
+                        dx = torus_delta(r->boids[j].pos.x - b.pos.x, worldW);
+                        dy = torus_delta(r->boids[j].pos.y - b.pos.y, worldH);
+                        d2 = dx * dx + dy * dy;
+
+                        if (d2 < desiredSeparation2 && d2 > 1e-6f) {
+                            Vec2 away = v_mul(v_norm((Vec2){dx, dy}), -1.0f);
+                            sumSep = v_add(sumSep, v_div(away, sqrtf(d2)));
+                        }
+
+                        if (r->boids[j].predator) {
+                            if (d2 < predAvoidRadius2 && d2 > 1e-6f) {
+                                Vec2 away = v_mul(v_norm((Vec2){dx, dy}), -1.0f);
+                                sumPred = v_add(sumPred, v_div(away, sqrtf(d2)));
+                            }
+                            continue;
+                        }
+
+                        if (r->boids[j].group != groupI) continue;
+
+                        if (d2 < neighborRadius2) {
+                            neighbors++;
+                            sumPos = v_add(sumPos, v_add(b.pos, (Vec2){dx, dy}));
+                            sumVel = v_add(sumVel, r->boids[j].vel);
+                        }
                     }
-                    continue;
-                }
-
-                if (r->boids[j].group != groupI) continue;
-
-                if (d2 < neighborRadius2) {
-                    neighbors++;
-                    sumPos = v_add(sumPos, v_add(b.pos, (Vec2){dx, dy}));
-                    sumVel = v_add(sumVel, r->boids[j].vel);
                 }
             }
 
@@ -29,6 +29,22 @@ typedef struct InputState {
     bool quit;
 } InputState;
 
+/*
+   Uniform torus grid rebuilt every tick from World.boids.
+   cellBoids holds the alive boid indices ordered by cell, cellStart[c]..cellStart[c + 1]
+   is the slice of cell c.
+*/
+typedef struct BoidGrid {
+    int cols;
+    int rows;
+    float cellW;
+    float cellH;
+    size_t cellCapacity;
+    size_t* cellStart;
+    size_t* cellBoids;
+    size_t* boidCell;
+} BoidGrid;
+
 typedef struct World {
     int width;
     int height;
@@ -37,6 +53,7 @@ typedef struct World {
     Boid* boids;
     Boid* boidsNext;
     Player player;
+    BoidGrid grid;
 } World;
 
 bool world_init(World* world, int width, int height, size_t boidCount);
@@ -46,4 +63,7 @@ void world_apply_player_input(World* world, const InputState* input, double dt);
 
 double world_step_seq(World* world, double dt);
 
+/* Rebuilds the neighbor grid from world->boids. Call once per tick before world_step_range. */
+void world_prepare_step(World* world);
+
 void world_step_range(const World* worldRead, World* worldWrite, size_t begin, size_t end, double dt);
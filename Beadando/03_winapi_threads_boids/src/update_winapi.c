@@ -132,6 +132,8 @@ void update_winapi_destroy(UpdateWinApi* u) {
 
 void update_winapi_step(UpdateWinApi* u, World* w, double dt) {
     Impl* impl = (Impl*)u->impl;
+
+    world_prepare_step(w);
     impl->world = w;
     impl->dt = dt;
     impl->finished = 0;